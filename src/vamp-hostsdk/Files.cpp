@@ -41,6 +41,8 @@
 #include <cctype> // tolower
 
 #include <cstring>
+#include <cstdio>
+#include <fstream>
 
 #ifdef _WIN32
 
@@ -53,6 +55,8 @@
 #include <cstdlib>
 #include <dirent.h>
 #include <dlfcn.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #ifdef __APPLE__
 #define PLUGIN_SUFFIX "dylib"
@@ -64,6 +68,24 @@
 
 using namespace std;
 
+#if defined(_WIN32) && defined(UNICODE)
+static bool
+toWide(const string &path, wstring &wide)
+{
+    int wlen = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), int(path.length()), 0, 0);
+    if (wlen < 0) {
+        cerr << "Vamp::HostExt: Unable to convert file path \""
+             << path << "\" to wide characters " << endl;
+        return false;
+    }
+    wide.resize(wlen);
+    if (wlen > 0) {
+        (void)MultiByteToWideChar(CP_UTF8, 0, path.c_str(), int(path.length()), &wide[0], wlen);
+    }
+    return true;
+}
+#endif
+
 vector<string>
 Files::listLibraryFiles()
 {
@@ -435,3 +457,176 @@ Files::getEnvUtf8(std::string variable, std::string &value)
     
 #endif
 }
+
+bool
+Files::getFileStamp(string path, unsigned long long &size, long long &modified)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+#ifdef UNICODE
+    int wlen = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), path.length(), 0, 0);
+    if (wlen < 0) {
+        cerr << "Vamp::HostExt: Unable to convert file path \""
+             << path << "\" to wide characters " << endl;
+        return false;
+    }
+    wchar_t *buffer = new wchar_t[wlen+1];
+    (void)MultiByteToWideChar(CP_UTF8, 0, path.c_str(), path.length(), buffer, wlen);
+    buffer[wlen] = L'\0';
+    BOOL ok = GetFileAttributesEx(buffer, GetFileExInfoStandard, &data);
+    delete[] buffer;
+#else
+    BOOL ok = GetFileAttributesEx(path.c_str(), GetFileExInfoStandard, &data);
+#endif
+    if (!ok) return false;
+    size = ((unsigned long long)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+    modified = (long long)(((unsigned long long)data.ftLastWriteTime.dwHighDateTime << 32) |
+                           data.ftLastWriteTime.dwLowDateTime);
+    return true;
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return false;
+    size = (unsigned long long)st.st_size;
+    modified = (long long)st.st_mtime * 1000000000LL;
+#if defined(__APPLE__)
+    modified += st.st_mtimespec.tv_nsec;
+#elif defined(__linux__)
+    modified += st.st_mtim.tv_nsec;
+#endif
+    return true;
+#endif
+}
+
+string
+Files::getCacheDirectory()
+{
+    string dir;
+#ifdef _WIN32
+    (void)getEnvUtf8("LOCALAPPDATA", dir);
+#else
+    if (getEnvUtf8("XDG_CACHE_HOME", dir) && dir != "") {
+        return dir;
+    }
+    string home;
+    if (getEnvUtf8("HOME", home) && home != "") {
+#ifdef __APPLE__
+        dir = home + "/Library/Caches";
+#else
+        dir = home + "/.cache";
+#endif
+    }
+#endif
+    return dir;
+}
+
+bool
+Files::replaceFile(string path, string contents)
+{
+    char suffix[40];
+#ifdef _WIN32
+    snprintf(suffix, sizeof(suffix), ".%lu.tmp", (unsigned long)GetCurrentProcessId());
+#else
+    snprintf(suffix, sizeof(suffix), ".%ld.tmp", (long)getpid());
+#endif
+    string tmpPath = path + suffix;
+
+    {
+        ofstream os(tmpPath.c_str(), ofstream::out | ofstream::binary |
+                    ofstream::trunc);
+        if (os.fail()) return false;
+        os << contents;
+        os.close();
+        if (os.fail()) {
+            remove(tmpPath.c_str());
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    // rename() will not replace an existing file here, and removing
+    // the old one first would leave a moment with no file at all
+#ifdef UNICODE
+    wstring wTmpPath, wPath;
+    BOOL ok = (toWide(tmpPath, wTmpPath) && toWide(path, wPath) &&
+               MoveFileEx(wTmpPath.c_str(), wPath.c_str(),
+                          MOVEFILE_REPLACE_EXISTING));
+#else
+    BOOL ok = MoveFileEx(tmpPath.c_str(), path.c_str(),
+                         MOVEFILE_REPLACE_EXISTING);
+#endif
+    if (!ok) {
+        remove(tmpPath.c_str());
+        return false;
+    }
+#else
+    if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+        remove(tmpPath.c_str());
+        return false;
+    }
+#endif
+    return true;
+}
+
+static bool
+isDirectory(string path)
+{
+#ifdef _WIN32
+#ifdef UNICODE
+    wstring wPath;
+    if (!toWide(path, wPath)) return false;
+    DWORD attributes = GetFileAttributes(wPath.c_str());
+#else
+    DWORD attributes = GetFileAttributes(path.c_str());
+#endif
+    return (attributes != INVALID_FILE_ATTRIBUTES &&
+            (attributes & FILE_ATTRIBUTE_DIRECTORY));
+#else
+    struct stat st;
+    return (stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode));
+#endif
+}
+
+static bool
+makeDirectory(string dir)
+{
+    if (isDirectory(dir)) return true;
+
+    // Create the parent first, working back only as far as the first
+    // directory that exists, so that drive and server prefixes on
+    // Windows are never themselves created
+#ifdef _WIN32
+    string::size_type sep = dir.find_last_of("\\/");
+#else
+    string::size_type sep = dir.find_last_of('/');
+#endif
+    if (sep != string::npos && sep > 0) {
+        if (!makeDirectory(dir.substr(0, sep))) return false;
+    }
+
+#ifdef _WIN32
+#ifdef UNICODE
+    wstring wDir;
+    if (toWide(dir, wDir)) (void)CreateDirectory(wDir.c_str(), 0);
+#else
+    (void)CreateDirectory(dir.c_str(), 0);
+#endif
+#else
+    (void)mkdir(dir.c_str(), 0777);
+#endif
+
+    // Another process may have created it in the meantime, so check
+    // the outcome rather than the result of the call
+    return isDirectory(dir);
+}
+
+bool
+Files::makeParentDirectory(string path)
+{
+#ifdef _WIN32
+    string::size_type sep = path.find_last_of("\\/");
+#else
+    string::size_type sep = path.find_last_of('/');
+#endif
+    if (sep == string::npos || sep == 0) return true;
+    return makeDirectory(path.substr(0, sep));
+}
@@ -65,6 +65,35 @@ public:
 
     static bool isNonNative32Bit();
     static bool getEnvUtf8(std::string variable, std::string &value);
+
+    /**
+     * Retrieve the size and modification time of a file, the latter
+     * in platform-dependent units. Return false if the file cannot
+     * be examined.
+     */
+    static bool getFileStamp(std::string path,
+                             unsigned long long &size,
+                             long long &modified);
+
+    /**
+     * Return the directory in which per-user cache files belong, or
+     * an empty string if there is none.
+     */
+    static std::string getCacheDirectory();
+
+    /**
+     * Write the given contents to a temporary file alongside path
+     * and move it into place, so that a reader sees either the old
+     * file or the complete new one.
+     */
+    static bool replaceFile(std::string path, std::string contents);
+
+    /**
+     * Create the directory that is to contain the given file path,
+     * and any missing directories above it, as "mkdir -p" would.
+     * Return true if the directory exists afterwards.
+     */
+    static bool makeParentDirectory(std::string path);
 };
 
 #endif
@@ -37,6 +37,9 @@
 
 #include <vector>
 #include <map>
+#include <cstring>
+#include <stdint.h>
+#include <atomic>
 
 #include <vamp-hostsdk/PluginBufferingAdapter.h>
 #include <vamp-hostsdk/PluginInputDomainAdapter.h>
@@ -75,22 +78,68 @@ public:
     void reset();
 
     FeatureSet process(const float *const *inputBuffers, RealTime timestamp);
+
+    void processChunk(const float *const *inputBuffers, size_t frames,
+                      RealTime timestamp, FeatureSet &features);
 		
     FeatureSet getRemainingFeatures();
+
+    void processInto(const float *const *inputBuffers, RealTime timestamp,
+                     FeatureBuffer &features);
+    void getRemainingFeaturesInto(FeatureBuffer &features);
+
+    bool setPushMode(size_t capacity, RealTime startTime);
+    size_t push(const float *const *inputBuffers, size_t frames);
+    FeatureSet pump();
+    void pumpInto(FeatureBuffer &features);
 		
 protected:
+    /**
+     * Allocate count floats starting on a 64-byte boundary, returning
+     * the aligned pointer and setting raw to the pointer to delete.
+     */
+    static float *allocateAligned(size_t count, float *&raw) {
+        raw = new float[count + 16];
+        uintptr_t p = reinterpret_cast<uintptr_t>(raw);
+        p = (p + 63) & ~uintptr_t(63);
+        return reinterpret_cast<float *>(p);
+    }
+
+    /**
+     * Round a channel length up to a multiple of 64 bytes, so that
+     * every channel in a channel-major slab is 64-byte aligned.
+     */
+    static size_t alignedStride(size_t n) {
+        return (n + 15) & ~size_t(15);
+    }
+    
+    /**
+     * A multi-channel single-producer, single-consumer ring buffer.
+     * The channels are stored one after another in a single aligned
+     * slab and share one reader and one writer index, so that they
+     * always advance together. The writer index is only modified by
+     * write() and zero(), and the reader index only by skip(), so one
+     * thread may write while another reads. Each side publishes its
+     * index with release semantics after touching the data, and
+     * acquires the other's before using it.
+     */
     class RingBuffer
     {
     public:
-        RingBuffer(int n) :
-            m_buffer(new float[n+1]), m_writer(0), m_reader(0), m_size(n+1) { }
-        virtual ~RingBuffer() { delete[] m_buffer; }
+        RingBuffer(int channels, int n) :
+            m_channels(channels), m_writer(0), m_reader(0), m_size(n+1),
+            m_stride(int(alignedStride(n+1))) {
+            m_data = allocateAligned(size_t(m_channels) * m_stride, m_raw);
+        }
+        virtual ~RingBuffer() { delete[] m_raw; }
 
         int getSize() const { return m_size-1; }
         void reset() { m_writer = 0; m_reader = 0; }
 
         int getReadSpace() const {
-            int writer = m_writer, reader = m_reader, space;
+            int writer = m_writer.load(std::memory_order_acquire);
+            int reader = m_reader.load(std::memory_order_acquire);
+            int space;
             if (writer > reader) space = writer - reader;
             else if (writer < reader) space = (writer + m_size) - reader;
             else space = 0;
@@ -98,41 +147,42 @@ protected:
         }
 
         int getWriteSpace() const {
-            int writer = m_writer;
-            int reader = m_reader;
+            int writer = m_writer.load(std::memory_order_acquire);
+            int reader = m_reader.load(std::memory_order_acquire);
             int space = (reader + m_size - writer - 1);
             if (space >= m_size) space -= m_size;
             return space;
         }
-        
-        int peek(float *destination, int n) const {
+
+        /**
+         * Copy n frames from the read position into the given
+         * buffers, one per channel, without consuming them.
+         */
+        int peek(float *const *destinations, int n) const {
 
             int available = getReadSpace();
 
             if (n > available) {
-                for (int i = available; i < n; ++i) {
-                    destination[i] = 0.f;
+                for (int c = 0; c < m_channels; ++c) {
+                    memset(destinations[c] + available, 0,
+                           (n - available) * sizeof(float));
                 }
                 n = available;
             }
             if (n == 0) return n;
 
-            int reader = m_reader;
+            int reader = m_reader.load(std::memory_order_relaxed);
             int here = m_size - reader;
-            const float *const bufbase = m_buffer + reader;
 
-            if (here >= n) {
-                for (int i = 0; i < n; ++i) {
-                    destination[i] = bufbase[i];
-                }
-            } else {
-                for (int i = 0; i < here; ++i) {
-                    destination[i] = bufbase[i];
-                }
-                float *const destbase = destination + here;
-                const int nh = n - here;
-                for (int i = 0; i < nh; ++i) {
-                    destbase[i] = m_buffer[i];
+            for (int c = 0; c < m_channels; ++c) {
+                const float *const buf = m_data + size_t(c) * m_stride;
+                float *const destination = destinations[c];
+                if (here >= n) {
+                    memcpy(destination, buf + reader, n * sizeof(float));
+                } else {
+                    memcpy(destination, buf + reader, here * sizeof(float));
+                    memcpy(destination + here, buf,
+                           (n - here) * sizeof(float));
                 }
             }
 
@@ -147,14 +197,18 @@ protected:
             }
             if (n == 0) return n;
 
-            int reader = m_reader;
+            int reader = m_reader.load(std::memory_order_relaxed);
             reader += n;
             while (reader >= m_size) reader -= m_size;
-            m_reader = reader;
+            m_reader.store(reader, std::memory_order_release);
             return n;
         }
-        
-        int write(const float *source, int n) {
+
+        /**
+         * Write n frames to every channel, taken from the given
+         * buffers, one per channel, starting at the given offset.
+         */
+        int write(const float *const *sources, int offset, int n) {
 
             int available = getWriteSpace();
             if (n > available) {
@@ -162,29 +216,23 @@ protected:
             }
             if (n == 0) return n;
 
-            int writer = m_writer;
+            int writer = m_writer.load(std::memory_order_relaxed);
             int here = m_size - writer;
-            float *const bufbase = m_buffer + writer;
-            
-            if (here >= n) {
-                for (int i = 0; i < n; ++i) {
-                    bufbase[i] = source[i];
-                }
-            } else {
-                for (int i = 0; i < here; ++i) {
-                    bufbase[i] = source[i];
-                }
-                const int nh = n - here;
-                const float *const srcbase = source + here;
-                float *const buf = m_buffer;
-                for (int i = 0; i < nh; ++i) {
-                    buf[i] = srcbase[i];
+
+            for (int c = 0; c < m_channels; ++c) {
+                float *const buf = m_data + size_t(c) * m_stride;
+                const float *const source = sources[c] + offset;
+                if (here >= n) {
+                    memcpy(buf + writer, source, n * sizeof(float));
+                } else {
+                    memcpy(buf + writer, source, here * sizeof(float));
+                    memcpy(buf, source + here, (n - here) * sizeof(float));
                 }
             }
 
             writer += n;
             while (writer >= m_size) writer -= m_size;
-            m_writer = writer;
+            m_writer.store(writer, std::memory_order_release);
 
             return n;
         }
@@ -197,36 +245,34 @@ protected:
             }
             if (n == 0) return n;
 
-            int writer = m_writer;
+            int writer = m_writer.load(std::memory_order_relaxed);
             int here = m_size - writer;
-            float *const bufbase = m_buffer + writer;
 
-            if (here >= n) {
-                for (int i = 0; i < n; ++i) {
-                    bufbase[i] = 0.f;
-                }
-            } else {
-                for (int i = 0; i < here; ++i) {
-                    bufbase[i] = 0.f;
-                }
-                const int nh = n - here;
-                for (int i = 0; i < nh; ++i) {
-                    m_buffer[i] = 0.f;
+            for (int c = 0; c < m_channels; ++c) {
+                float *const buf = m_data + size_t(c) * m_stride;
+                if (here >= n) {
+                    memset(buf + writer, 0, n * sizeof(float));
+                } else {
+                    memset(buf + writer, 0, here * sizeof(float));
+                    memset(buf, 0, (n - here) * sizeof(float));
                 }
             }
             
             writer += n;
             while (writer >= m_size) writer -= m_size;
-            m_writer = writer;
+            m_writer.store(writer, std::memory_order_release);
 
             return n;
         }
 
     protected:
-        float *m_buffer;
-        int    m_writer;
-        int    m_reader;
+        int    m_channels;
+        float *m_raw;
+        float *m_data;
+        std::atomic<int> m_writer;
+        std::atomic<int> m_reader;
         int    m_size;
+        int    m_stride;
 
     private:
         RingBuffer(const RingBuffer &); // not provided
@@ -241,16 +287,42 @@ protected:
     size_t m_stepSize;       // value actually used to initialise plugin
     size_t m_blockSize;      // value actually used to initialise plugin
     size_t m_channels;
-    vector<RingBuffer *> m_queue;
-    float **m_buffers;
+    RingBuffer *m_queue;
+    float **m_buffers;       // one per channel, in a single aligned slab
+    float *m_bufferData;     // the allocation behind m_buffers
+    const float **m_direct;  // frame pointers into the caller's buffers
     float m_inputSampleRate;
     long m_frame;
     bool m_unrun;
+    bool m_pushMode;
+    long m_pushStartFrame;
     mutable OutputList m_outputs;
-    mutable std::map<int, bool> m_rewriteOutputTimes;
-    std::map<int, int> m_fixedRateFeatureNos; // output no -> feature no
+
+    // Per-output state, indexed by output number and sized to match
+    // m_outputs whenever that is refreshed
+    mutable vector<bool> m_rewriteOutputTimes;
+    mutable vector<double> m_outputRates;        // for fixed-rate outputs
+    mutable vector<int> m_fixedRateFeatureNos;   // next feature number
+
+    // Features are gathered from the plugin into m_blockFeatures one
+    // block at a time, and returned from the FeatureSet-based calls
+    // by way of m_features
+    FeatureBuffer m_blockFeatures;
+    FeatureBuffer m_features;
+
+    bool shouldRewriteOutputTimes(int outputNo) const {
+        return outputNo >= 0 &&
+            outputNo < int(m_rewriteOutputTimes.size()) &&
+            m_rewriteOutputTimes[outputNo];
+    }
 		
-    void processBlock(FeatureSet& allFeatureSets);
+    bool checkProcessable(const char *fn) const;
+    void processInput(const float *const *inputBuffers, int frames,
+                      RealTime timestamp, FeatureBuffer &allFeatures);
+    void queueInput(const float *const *inputBuffers, int offset, int n,
+                    FeatureBuffer &allFeatures);
+    void processBlock(FeatureBuffer &allFeatures);
+    void processFrame(const float *const *buffers, FeatureBuffer &allFeatures);
     void adjustFixedRateFeatureTime(int outputNo, Feature &);
 };
 		
@@ -345,11 +417,58 @@ PluginBufferingAdapter::process(const float *const *inputBuffers,
     return m_impl->process(inputBuffers, timestamp);
 }
 		
+void
+PluginBufferingAdapter::processChunk(const float *const *inputBuffers,
+                                     size_t frames,
+                                     RealTime timestamp,
+                                     FeatureSet &features)
+{
+    m_impl->processChunk(inputBuffers, frames, timestamp, features);
+}
+
 PluginBufferingAdapter::FeatureSet
 PluginBufferingAdapter::getRemainingFeatures()
 {
     return m_impl->getRemainingFeatures();
 }
+
+void
+PluginBufferingAdapter::processInto(const float *const *inputBuffers,
+                                    RealTime timestamp,
+                                    FeatureBuffer &features)
+{
+    m_impl->processInto(inputBuffers, timestamp, features);
+}
+
+void
+PluginBufferingAdapter::getRemainingFeaturesInto(FeatureBuffer &features)
+{
+    m_impl->getRemainingFeaturesInto(features);
+}
+
+bool
+PluginBufferingAdapter::setPushMode(size_t capacity, RealTime startTime)
+{
+    return m_impl->setPushMode(capacity, startTime);
+}
+
+size_t
+PluginBufferingAdapter::push(const float *const *inputBuffers, size_t frames)
+{
+    return m_impl->push(inputBuffers, frames);
+}
+
+PluginBufferingAdapter::FeatureSet
+PluginBufferingAdapter::pump()
+{
+    return m_impl->pump();
+}
+
+void
+PluginBufferingAdapter::pumpInto(FeatureBuffer &features)
+{
+    m_impl->pumpInto(features);
+}
 		
 PluginBufferingAdapter::Impl::Impl(Plugin *plugin, float inputSampleRate) :
     m_plugin(plugin),
@@ -362,9 +481,13 @@ PluginBufferingAdapter::Impl::Impl(Plugin *plugin, float inputSampleRate) :
     m_channels(0), 
     m_queue(0),
     m_buffers(0),
+    m_bufferData(0),
+    m_direct(0),
     m_inputSampleRate(inputSampleRate),
     m_frame(0),
-    m_unrun(true)
+    m_unrun(true),
+    m_pushMode(false),
+    m_pushStartFrame(0)
 {
     (void)getOutputDescriptors(); // set up m_outputs and m_rewriteOutputTimes
 }
@@ -373,11 +496,10 @@ PluginBufferingAdapter::Impl::~Impl()
 {
     // the adapter will delete the plugin
 
-    for (size_t i = 0; i < m_channels; ++i) {
-        delete m_queue[i];
-        delete[] m_buffers[i];
-    }
+    delete m_queue;
     delete[] m_buffers;
+    delete[] m_bufferData;
+    delete[] m_direct;
 }
 		
 void
@@ -478,12 +600,17 @@ PluginBufferingAdapter::Impl::initialise(size_t channels, size_t stepSize, size_
 //    std::cerr << "PluginBufferingAdapter::initialise: NOTE: stepSize " << m_inputStepSize << " -> " << m_stepSize 
 //              << ", blockSize " << m_inputBlockSize << " -> " << m_blockSize << std::endl;			
 
-    m_buffers = new float *[m_channels];
+    m_queue = new RingBuffer(int(m_channels),
+                             int(m_blockSize + m_inputBlockSize));
 
+    size_t stride = alignedStride(m_blockSize);
+    float *data = allocateAligned(m_channels * stride, m_bufferData);
+    m_buffers = new float *[m_channels];
     for (size_t i = 0; i < m_channels; ++i) {
-        m_queue.push_back(new RingBuffer(int(m_blockSize + m_inputBlockSize)));
-        m_buffers[i] = new float[m_blockSize];
+        m_buffers[i] = data + i * stride;
     }
+
+    m_direct = new const float *[m_channels];
     
     bool success = m_plugin->initialise(m_channels, m_stepSize, m_blockSize);
 
@@ -510,8 +637,18 @@ PluginBufferingAdapter::Impl::getOutputDescriptors() const
 
     PluginBufferingAdapter::OutputList outs = m_outputs;
 
+    m_rewriteOutputTimes.resize(outs.size());
+    m_outputRates.resize(outs.size());
+    m_fixedRateFeatureNos.resize(outs.size(), 0);
+
     for (int i = 0; i < int(outs.size()); ++i) {
 
+        double rate = m_outputs[i].sampleRate;
+        if (rate == 0.0) {
+            rate = m_inputSampleRate / float(m_stepSize);
+        }
+        m_outputRates[i] = rate;
+
         switch (outs[i].sampleType) {
 
         case OutputDescriptor::OneSamplePerStep:
@@ -563,14 +700,12 @@ PluginBufferingAdapter::Impl::selectProgram(std::string name)
 void
 PluginBufferingAdapter::Impl::reset()
 {
-    m_frame = 0;
-    m_unrun = true;
+    m_frame = m_pushStartFrame;
+    m_unrun = !m_pushMode;
 
-    for (size_t i = 0; i < m_queue.size(); ++i) {
-        m_queue[i]->reset();
-    }
+    if (m_queue) m_queue->reset();
 
-    m_fixedRateFeatureNos.clear();
+    m_fixedRateFeatureNos.assign(m_fixedRateFeatureNos.size(), 0);
 
     m_plugin->reset();
 }
@@ -578,53 +713,249 @@ PluginBufferingAdapter::Impl::reset()
 PluginBufferingAdapter::FeatureSet
 PluginBufferingAdapter::Impl::process(const float *const *inputBuffers,
                                       RealTime timestamp)
+{
+    m_features.clear();
+
+    if (checkProcessable("process")) {
+        processInput(inputBuffers, int(m_inputBlockSize), timestamp,
+                     m_features);
+    }
+
+    return m_features.toFeatureSet();
+}
+
+void
+PluginBufferingAdapter::Impl::processInto(const float *const *inputBuffers,
+                                          RealTime timestamp,
+                                          FeatureBuffer &features)
+{
+    features.clear();
+
+    if (checkProcessable("processInto")) {
+        processInput(inputBuffers, int(m_inputBlockSize), timestamp,
+                     features);
+    }
+}
+
+void
+PluginBufferingAdapter::Impl::processChunk(const float *const *inputBuffers,
+                                           size_t frames,
+                                           RealTime timestamp,
+                                           FeatureSet &allFeatureSets)
+{
+    if (!checkProcessable("processChunk")) {
+        return;
+    }
+
+    m_features.clear();
+
+    // processInput counts frames in ints, including up to a block of
+    // input already queued, so a longer chunk is passed to it in
+    // slices small enough that those counts cannot overflow
+    const size_t maxSlice = size_t(1) << 30;
+
+    if (frames <= maxSlice) {
+        processInput(inputBuffers, int(frames), timestamp, m_features);
+    } else {
+        vector<const float *> slice(m_channels);
+        const int rate = int(m_inputSampleRate + 0.5);
+        size_t done = 0;
+        while (done < frames) {
+            size_t n = frames - done;
+            if (n > maxSlice) n = maxSlice;
+            for (size_t c = 0; c < m_channels; ++c) {
+                slice[c] = inputBuffers[c] + done;
+            }
+            processInput(&slice[0], int(n), timestamp, m_features);
+            timestamp = timestamp + RealTime::frame2RealTime(long(n), rate);
+            done += n;
+        }
+    }
+
+    m_features.addTo(allFeatureSets);
+}
+
+bool
+PluginBufferingAdapter::Impl::checkProcessable(const char *fn) const
 {
     if (m_inputStepSize == 0) {
-        std::cerr << "PluginBufferingAdapter::process: ERROR: Plugin has not been initialised" << std::endl;
-        return FeatureSet();
+        std::cerr << "PluginBufferingAdapter::" << fn << ": ERROR: Plugin has not been initialised" << std::endl;
+        return false;
+    }
+
+    if (m_pushMode) {
+        std::cerr << "PluginBufferingAdapter::" << fn << ": ERROR: Cannot be used in push mode; use push() and pump() instead" << std::endl;
+        return false;
     }
 
-    FeatureSet allFeatureSets;
+    return true;
+}
 
+void
+PluginBufferingAdapter::Impl::processInput(const float *const *inputBuffers,
+                                           int input,
+                                           RealTime timestamp,
+                                           FeatureBuffer &allFeatures)
+{
     if (m_unrun) {
         m_frame = RealTime::realTime2Frame(timestamp,
                                            int(m_inputSampleRate + 0.5));
         m_unrun = false;
     }
-			
-    // queue the new input
+
+    // Measuring positions from the start of the queued input, this
+    // call's input runs from queued to queued + input, and plugin
+    // blocks start at every multiple of the step. The blocks starting
+    // at or after queued that end within this call's input can be
+    // passed to the plugin straight from the caller's buffers without
+    // copying them. That is every block when the host and plugin
+    // block sizes are equal and the step divides them.
+
+    const int step = int(m_stepSize);
+    const int block = int(m_blockSize);
+    const int queued = m_queue->getReadSpace();
+
+    // the first block that starts within this call's input
+    const int firstDirect = (queued + step - 1) / step;
+
+    if (firstDirect * step + block > queued + input) {
+        // No such block: queue all of the new input
+        queueInput(inputBuffers, 0, input, allFeatures);
+        return;
+    }
+
+    // The blocks before firstDirect straddle the queued input and
+    // ours, and must be assembled in the queue as usual. We only
+    // need to queue enough of our input to complete the last of them
+
+    if (firstDirect > 0) {
+        int needed = (firstDirect - 1) * step + block - queued;
+        queueInput(inputBuffers, 0, needed, allFeatures);
+    }
+
+    // Now the blocks lying wholly within our input
+
+    int start = firstDirect * step - queued;
+
+    while (start + block <= input) {
+        for (size_t i = 0; i < m_channels; ++i) {
+            m_direct[i] = inputBuffers[i] + start;
+        }
+        processFrame(m_direct, allFeatures);
+        start += step;
+    }
+
+    // Finally, replace whatever remains in the queue with the tail of
+    // our input from the start of the next block, which the next call
+    // will need
+
+    m_queue->skip(m_queue->getReadSpace());
+    m_queue->write(inputBuffers, start, input - start);
+}
+
+void
+PluginBufferingAdapter::Impl::queueInput(const float *const *inputBuffers,
+                                         int offset, int n,
+                                         FeatureBuffer &allFeatures)
+{
+    // Queue n frames of input from the given offset, processing
+    // every whole block as it becomes available. For input of up to
+    // the host block size that we were initialised with, the queue
+    // always has room for all of it at once; larger chunks go in as
+    // space is freed
+
+    const int end = offset + n;
     
-    for (size_t i = 0; i < m_channels; ++i) {
-        int written = m_queue[i]->write(inputBuffers[i], int(m_inputBlockSize));
-        if (written < int(m_inputBlockSize) && i == 0) {
-            std::cerr << "WARNING: PluginBufferingAdapter::Impl::process: "
-                      << "Buffer overflow: wrote " << written 
-                      << " of " << m_inputBlockSize 
+    while (true) {
+
+        int written = m_queue->write(inputBuffers, offset, end - offset);
+        offset += written;
+        
+        while (m_queue->getReadSpace() >= int(m_blockSize)) {
+            processBlock(allFeatures);
+        }
+
+        if (offset >= end) break;
+
+        if (written == 0) {
+            std::cerr << "WARNING: PluginBufferingAdapter::Impl::queueInput: "
+                      << "Buffer overflow: dropped " << (end - offset)
                       << " input samples (for plugin step size "
                       << m_stepSize << ", block size " << m_blockSize << ")"
                       << std::endl;
+            break;
         }
-    }    
-    
-    // process as much as we can
+    }
+}
 
-    while (m_queue[0]->getReadSpace() >= int(m_blockSize)) {
-        processBlock(allFeatureSets);
-    }	
+bool
+PluginBufferingAdapter::Impl::setPushMode(size_t capacity, RealTime startTime)
+{
+    if (m_inputStepSize == 0) {
+        std::cerr << "PluginBufferingAdapter::setPushMode: ERROR: Plugin has not been initialised" << std::endl;
+        return false;
+    }
+
+    // The queues must be able to hold at least a whole block, or
+    // pump() would never find one to process
     
-    return allFeatureSets;
+    if (capacity < m_blockSize) {
+        capacity = m_blockSize;
+    }
+
+    delete m_queue;
+    m_queue = new RingBuffer(int(m_channels), int(capacity));
+
+    m_pushMode = true;
+    m_pushStartFrame = RealTime::realTime2Frame
+        (startTime, int(m_inputSampleRate + 0.5));
+    m_frame = m_pushStartFrame;
+    m_unrun = false;
+
+    return true;
+}
+
+size_t
+PluginBufferingAdapter::Impl::push(const float *const *inputBuffers,
+                                   size_t frames)
+{
+    if (!m_pushMode) {
+        std::cerr << "PluginBufferingAdapter::push: ERROR: Not in push mode" << std::endl;
+        return 0;
+    }
+
+    return size_t(m_queue->write(inputBuffers, 0, int(frames)));
+}
+
+PluginBufferingAdapter::FeatureSet
+PluginBufferingAdapter::Impl::pump()
+{
+    pumpInto(m_features);
+    return m_features.toFeatureSet();
 }
+
+void
+PluginBufferingAdapter::Impl::pumpInto(FeatureBuffer &features)
+{
+    features.clear();
     
+    if (!m_pushMode) {
+        std::cerr << "PluginBufferingAdapter::pump: ERROR: Not in push mode" << std::endl;
+        return;
+    }
+
+    while (m_queue->getReadSpace() >= int(m_blockSize)) {
+        processBlock(features);
+    }
+}
+
 void
 PluginBufferingAdapter::Impl::adjustFixedRateFeatureTime(int outputNo,
                                                          Feature &feature)
 {
 //    cerr << "adjustFixedRateFeatureTime: from " << feature.timestamp;
     
-    double rate = m_outputs[outputNo].sampleRate;
-    if (rate == 0.0) {
-        rate = m_inputSampleRate / float(m_stepSize);
-    }
+    double rate = m_outputRates[outputNo];
     
     if (feature.hasTimestamp) {
         double secs = feature.timestamp.sec;
@@ -646,57 +977,71 @@ PluginBufferingAdapter::Impl::adjustFixedRateFeatureTime(int outputNo,
 PluginBufferingAdapter::FeatureSet
 PluginBufferingAdapter::Impl::getRemainingFeatures() 
 {
-    FeatureSet allFeatureSets;
+    getRemainingFeaturesInto(m_features);
+    return m_features.toFeatureSet();
+}
+
+void
+PluginBufferingAdapter::Impl::getRemainingFeaturesInto(FeatureBuffer &allFeatures)
+{
+    allFeatures.clear();
     
     // process remaining samples in queue
-    while (m_queue[0]->getReadSpace() >= int(m_blockSize)) {
-        processBlock(allFeatureSets);
+    while (m_queue->getReadSpace() >= int(m_blockSize)) {
+        processBlock(allFeatures);
     }
     
     // pad any last samples remaining and process
-    if (m_queue[0]->getReadSpace() > 0) {
-        for (size_t i = 0; i < m_channels; ++i) {
-            m_queue[i]->zero(int(m_blockSize) - m_queue[i]->getReadSpace());
-        }
-        processBlock(allFeatureSets);
+    if (m_queue->getReadSpace() > 0) {
+        m_queue->zero(int(m_blockSize) - m_queue->getReadSpace());
+        processBlock(allFeatures);
     }			
     
     // get remaining features			
 
-    FeatureSet featureSet = m_plugin->getRemainingFeatures();
+    getRemainingPluginFeaturesInto(m_plugin, m_blockFeatures);
 
-    for (map<int, FeatureList>::iterator iter = featureSet.begin();
-         iter != featureSet.end(); ++iter) {
+    for (int outputNo = 0; outputNo < m_blockFeatures.getOutputCount();
+         ++outputNo) {
 
-        int outputNo = iter->first;
-        FeatureList featureList = iter->second;
+        size_t count = m_blockFeatures.getFeatureCount(outputNo);
+        if (count == 0) continue;
 
-        for (size_t i = 0; i < featureList.size(); ++i) {
+        bool fixed = (shouldRewriteOutputTimes(outputNo) &&
+                      m_outputs[outputNo].sampleType ==
+                      OutputDescriptor::FixedSampleRate);
 
-            if (m_outputs[outputNo].sampleType ==
-                OutputDescriptor::FixedSampleRate) {
-                adjustFixedRateFeatureTime(outputNo, featureList[i]);
-            }
+        for (size_t i = 0; i < count; ++i) {
 
-            allFeatureSets[outputNo].push_back(featureList[i]);
+            Feature &feature = allFeatures.addFeature
+                (outputNo, m_blockFeatures.getFeature(outputNo, i));
+
+            if (fixed) {
+                adjustFixedRateFeatureTime(outputNo, feature);
+            }
         }
     }
-    
-    return allFeatureSets;
 }
     
 void
-PluginBufferingAdapter::Impl::processBlock(FeatureSet& allFeatureSets)
+PluginBufferingAdapter::Impl::processBlock(FeatureBuffer &allFeatures)
 {
-    for (size_t i = 0; i < m_channels; ++i) {
-        m_queue[i]->peek(m_buffers[i], int(m_blockSize));
-    }
+    m_queue->peek(m_buffers, int(m_blockSize));
 
+    processFrame(m_buffers, allFeatures);
+
+    m_queue->skip(int(m_stepSize));
+}
+
+void
+PluginBufferingAdapter::Impl::processFrame(const float *const *buffers,
+                                           FeatureBuffer &allFeatures)
+{
     long frame = m_frame;
     RealTime timestamp = RealTime::frame2RealTime
         (frame, int(m_inputSampleRate + 0.5));
 
-    FeatureSet featureSet = m_plugin->process(m_buffers, timestamp);
+    processPluginInto(m_plugin, buffers, timestamp, m_blockFeatures);
     
     PluginWrapper *wrapper = dynamic_cast<PluginWrapper *>(m_plugin);
     RealTime adjustment;
@@ -706,27 +1051,32 @@ PluginBufferingAdapter::Impl::processBlock(FeatureSet& allFeatureSets)
         if (ida) adjustment = ida->getTimestampAdjustment();
     }
 
-    for (FeatureSet::iterator iter = featureSet.begin();
-         iter != featureSet.end(); ++iter) {
+    for (int outputNo = 0; outputNo < m_blockFeatures.getOutputCount();
+         ++outputNo) {
 
-        int outputNo = iter->first;
+        size_t count = m_blockFeatures.getFeatureCount(outputNo);
+        if (count == 0) continue;
 
-        if (m_rewriteOutputTimes[outputNo]) {
+        if (shouldRewriteOutputTimes(outputNo)) {
             
-            FeatureList featureList = iter->second;
+            OutputDescriptor::SampleType type =
+                m_outputs[outputNo].sampleType;
 	
-            for (size_t i = 0; i < featureList.size(); ++i) {
+            for (size_t i = 0; i < count; ++i) {
+
+                Feature &feature = allFeatures.addFeature
+                    (outputNo, m_blockFeatures.getFeature(outputNo, i));
 
-                switch (m_outputs[outputNo].sampleType) {
+                switch (type) {
 
                 case OutputDescriptor::OneSamplePerStep:
                     // use our internal timestamp, always
-                    featureList[i].timestamp = timestamp + adjustment;
-                    featureList[i].hasTimestamp = true;
+                    feature.timestamp = timestamp + adjustment;
+                    feature.hasTimestamp = true;
                     break;
 
                 case OutputDescriptor::FixedSampleRate:
-                    adjustFixedRateFeatureTime(outputNo, featureList[i]);
+                    adjustFixedRateFeatureTime(outputNo, feature);
                     break;
 
                 case OutputDescriptor::VariableSampleRate:
@@ -736,22 +1086,15 @@ PluginBufferingAdapter::Impl::processBlock(FeatureSet& allFeatureSets)
                 default:
                     break;
                 }
-            
-                allFeatureSets[outputNo].push_back(featureList[i]);
             }
         } else {
-            for (size_t i = 0; i < iter->second.size(); ++i) {
-                allFeatureSets[outputNo].push_back(iter->second[i]);
+            for (size_t i = 0; i < count; ++i) {
+                allFeatures.addFeature
+                    (outputNo, m_blockFeatures.getFeature(outputNo, i));
             }
         }
     }
     
-    // step forward
-
-    for (size_t i = 0; i < m_channels; ++i) {
-        m_queue[i]->skip(int(m_stepSize));
-    }
-    
     // increment internal frame counter each time we step forward
     m_frame += m_stepSize;
 }
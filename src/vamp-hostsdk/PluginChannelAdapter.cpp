@@ -35,6 +35,12 @@
 */
 
 #include <vamp-hostsdk/PluginChannelAdapter.h>
+#include <vamp-hostsdk/PluginInputDomainAdapter.h>
+
+#include <algorithm>
+#include <iostream>
+
+#include "../vamp-sdk/FFTsimd.h"
 
 _VAMP_SDK_HOSTSPACE_BEGIN(PluginChannelAdapter.cpp)
 
@@ -42,6 +48,310 @@ namespace Vamp {
 
 namespace HostExt {
 
+// Kernels for mixing down and de-interleaving. We borrow the SSE2 or
+// NEON selection from FFTsimd.h (NEON only with VAMP_KISS_FFT_NEON);
+// when neither is enabled (including in unoptimised builds) only the
+// scalar loops are used. The vector
+// code adds the channels in the same order as the scalar code and
+// uses separate multiplies and adds, so the results are identical.
+
+#ifdef VAMP_KISS_FFT_SIMD
+
+#ifdef VAMP_KISS_SIMD_SSE2
+
+typedef __m128 MixVector;
+
+static inline MixVector mixLoad(const float *p) { return _mm_loadu_ps(p); }
+static inline void mixStore(float *p, MixVector v) { _mm_storeu_ps(p, v); }
+static inline MixVector mixAdd(MixVector a, MixVector b) { return _mm_add_ps(a, b); }
+static inline MixVector mixMul(MixVector a, MixVector b) { return _mm_mul_ps(a, b); }
+static inline MixVector mixDiv(MixVector a, MixVector b) { return _mm_div_ps(a, b); }
+static inline MixVector mixSplat(float f) { return _mm_set1_ps(f); }
+
+static inline void
+mixTranspose(MixVector *r)
+{
+    _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+}
+
+static inline void
+mixDeinterleave2(const float *p, MixVector &a, MixVector &b)
+{
+    MixVector lo = _mm_loadu_ps(p);
+    MixVector hi = _mm_loadu_ps(p + 4);
+    a = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    b = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+#else
+
+typedef float32x4_t MixVector;
+
+static inline MixVector mixLoad(const float *p) { return vld1q_f32(p); }
+static inline void mixStore(float *p, MixVector v) { vst1q_f32(p, v); }
+static inline MixVector mixAdd(MixVector a, MixVector b) { return vaddq_f32(a, b); }
+static inline MixVector mixMul(MixVector a, MixVector b) { return vmulq_f32(a, b); }
+static inline MixVector mixDiv(MixVector a, MixVector b) { return vdivq_f32(a, b); }
+static inline MixVector mixSplat(float f) { return vdupq_n_f32(f); }
+
+static inline void
+mixTranspose(MixVector *r)
+{
+    float32x4x2_t t01 = vtrnq_f32(r[0], r[1]);
+    float32x4x2_t t23 = vtrnq_f32(r[2], r[3]);
+    r[0] = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+    r[1] = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+    r[2] = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    r[3] = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+static inline void
+mixDeinterleave2(const float *p, MixVector &a, MixVector &b)
+{
+    float32x4x2_t v = vld2q_f32(p);
+    a = v.val[0];
+    b = v.val[1];
+}
+
+#endif
+
+/**
+ * Load four frames of the given channel group from interleaved input
+ * and transpose them, so that r[i] holds channel first + i.
+ */
+static inline void
+mixLoadGroup(const float *in, int channels, int first, MixVector *r)
+{
+    for (int i = 0; i < 4; ++i) {
+        r[i] = mixLoad(in + i * channels + first);
+    }
+    mixTranspose(r);
+}
+
+/**
+ * The first channel of each group of four channels covering the
+ * given number of outputs from an interleaved frame of the given
+ * number of channels (at least four). The final group is moved back
+ * so as not to read past the end of the frame, and so may overlap
+ * the one before it.
+ */
+static inline int
+mixGroupStart(int c, int channels)
+{
+    return (c + 4 > channels ? channels - 4 : c);
+}
+
+#endif
+
+/**
+ * Mix n samples of the given planar channels into out: either the
+ * mean, if gains is null, or the sum of each channel multiplied by
+ * its gain. The channel count is a template parameter for the common
+ * layouts, so that the channel loop is unrolled, with 0 meaning a
+ * count only known at runtime.
+ */
+template <int C>
+static void
+mixdownPlanar(const float *const *in, int channels, const float *gains,
+              float *out, int n)
+{
+    if (C) channels = C;
+    int j = 0;
+
+#ifdef VAMP_KISS_FFT_SIMD
+    if (gains) {
+        for (; j + 4 <= n; j += 4) {
+            MixVector acc = mixMul(mixLoad(in[0] + j), mixSplat(gains[0]));
+            for (int i = 1; i < channels; ++i) {
+                acc = mixAdd(acc, mixMul(mixLoad(in[i] + j),
+                                         mixSplat(gains[i])));
+            }
+            mixStore(out + j, acc);
+        }
+    } else {
+        MixVector count = mixSplat(float(channels));
+        for (; j + 4 <= n; j += 4) {
+            MixVector acc = mixLoad(in[0] + j);
+            for (int i = 1; i < channels; ++i) {
+                acc = mixAdd(acc, mixLoad(in[i] + j));
+            }
+            mixStore(out + j, mixDiv(acc, count));
+        }
+    }
+#endif
+
+    if (gains) {
+        for (; j < n; ++j) {
+            float acc = in[0][j] * gains[0];
+            for (int i = 1; i < channels; ++i) {
+                acc += in[i][j] * gains[i];
+            }
+            out[j] = acc;
+        }
+    } else {
+        for (; j < n; ++j) {
+            float acc = in[0][j];
+            for (int i = 1; i < channels; ++i) {
+                acc += in[i][j];
+            }
+            out[j] = acc / float(channels);
+        }
+    }
+}
+
+static void
+mixdownPlanar(const float *const *in, int channels, const float *gains,
+              float *out, int n)
+{
+    switch (channels) {
+    case 2: mixdownPlanar<2>(in, channels, gains, out, n); break;
+    case 4: mixdownPlanar<4>(in, channels, gains, out, n); break;
+    case 6: mixdownPlanar<6>(in, channels, gains, out, n); break;
+    case 8: mixdownPlanar<8>(in, channels, gains, out, n); break;
+    default: mixdownPlanar<0>(in, channels, gains, out, n); break;
+    }
+}
+
+/**
+ * As mixdownPlanar, but reading n frames of interleaved input
+ * directly, so that no de-interleaved copy is needed.
+ */
+template <int C>
+static void
+mixdownInterleaved(const float *in, int channels, const float *gains,
+                   float *out, int n)
+{
+    if (C) channels = C;
+    int j = 0;
+
+#ifdef VAMP_KISS_FFT_SIMD
+    if (channels == 2 || channels >= 4) {
+        MixVector count = mixSplat(float(channels));
+        MixVector g[2] = { count, count }; // only read if gains set
+        if (gains && channels == 2) {
+            g[0] = mixSplat(gains[0]);
+            g[1] = mixSplat(gains[1]);
+        }
+        for (; j + 4 <= n; j += 4) {
+            const float *frames = in + j * channels;
+            MixVector acc = count; // always overwritten below
+            if (channels == 2) {
+                MixVector a, b;
+                mixDeinterleave2(frames, a, b);
+                if (gains) {
+                    acc = mixAdd(mixMul(a, g[0]), mixMul(b, g[1]));
+                } else {
+                    acc = mixAdd(a, b);
+                }
+            } else {
+                MixVector r[4];
+                int done = 0;
+                while (done < channels) {
+                    int first = mixGroupStart(done, channels);
+                    mixLoadGroup(frames, channels, first, r);
+                    for (int i = done - first; i < 4; ++i) {
+                        MixVector v = r[i];
+                        if (gains) {
+                            v = mixMul(v, mixSplat(gains[first + i]));
+                        }
+                        acc = (first + i == 0) ? v : mixAdd(acc, v);
+                    }
+                    done = first + 4;
+                }
+            }
+            mixStore(out + j, gains ? acc : mixDiv(acc, count));
+        }
+    }
+#endif
+
+    for (; j < n; ++j) {
+        const float *frame = in + j * channels;
+        float acc;
+        if (gains) {
+            acc = frame[0] * gains[0];
+            for (int i = 1; i < channels; ++i) {
+                acc += frame[i] * gains[i];
+            }
+        } else {
+            acc = frame[0];
+            for (int i = 1; i < channels; ++i) {
+                acc += frame[i];
+            }
+            acc /= float(channels);
+        }
+        out[j] = acc;
+    }
+}
+
+static void
+mixdownInterleaved(const float *in, int channels, const float *gains,
+                   float *out, int n)
+{
+    switch (channels) {
+    case 2: mixdownInterleaved<2>(in, channels, gains, out, n); break;
+    case 4: mixdownInterleaved<4>(in, channels, gains, out, n); break;
+    case 6: mixdownInterleaved<6>(in, channels, gains, out, n); break;
+    case 8: mixdownInterleaved<8>(in, channels, gains, out, n); break;
+    default: mixdownInterleaved<0>(in, channels, gains, out, n); break;
+    }
+}
+
+/**
+ * De-interleave the first outputs channels of n frames of input with
+ * the given number of channels.
+ */
+template <int C>
+static void
+deinterleave(const float *in, int channels, float *const *out, int outputs,
+             int n)
+{
+    if (C) channels = C;
+    int j = 0;
+
+#ifdef VAMP_KISS_FFT_SIMD
+    if (channels == 2) {
+        for (; j + 4 <= n; j += 4) {
+            MixVector a, b;
+            mixDeinterleave2(in + j * 2, a, b);
+            mixStore(out[0] + j, a);
+            if (outputs > 1) mixStore(out[1] + j, b);
+        }
+    } else if (channels >= 4) {
+        for (; j + 4 <= n; j += 4) {
+            const float *frames = in + j * channels;
+            MixVector r[4];
+            for (int c = 0; c < outputs; c += 4) {
+                int first = mixGroupStart(c, channels);
+                mixLoadGroup(frames, channels, first, r);
+                for (int i = c - first; i < 4 && first + i < outputs; ++i) {
+                    mixStore(out[first + i] + j, r[i]);
+                }
+            }
+        }
+    }
+#endif
+
+    for (int i = 0; i < outputs; ++i) {
+        float *o = out[i];
+        for (int k = j; k < n; ++k) {
+            o[k] = in[k * channels + i];
+        }
+    }
+}
+
+static void
+deinterleave(const float *in, int channels, float *const *out, int outputs,
+             int n)
+{
+    switch (channels) {
+    case 2: deinterleave<2>(in, channels, out, outputs, n); break;
+    case 4: deinterleave<4>(in, channels, out, outputs, n); break;
+    case 6: deinterleave<6>(in, channels, out, outputs, n); break;
+    case 8: deinterleave<8>(in, channels, out, outputs, n); break;
+    default: deinterleave<0>(in, channels, out, outputs, n); break;
+    }
+}
+
 class PluginChannelAdapter::Impl
 {
 public:
@@ -50,8 +360,19 @@ public:
 
     bool initialise(size_t channels, size_t stepSize, size_t blockSize);
 
-    FeatureSet process(const float *const *inputBuffers, RealTime timestamp);
+    FeatureSet process(const float *const *inputBuffers, RealTime timestamp,
+                       FeatureBuffer *into = 0);
     FeatureSet processInterleaved(const float *inputBuffers, RealTime timestamp);
+    FeatureSet processStrided(const float *const *inputBuffers, size_t stride,
+                              RealTime timestamp);
+
+    void setMixGains(const std::vector<float> &gains);
+
+    /**
+     * Return the gains in use if mixing down to mono with gains,
+     * otherwise an empty vector.
+     */
+    std::vector<float> getMixdownGains() const;
 
 protected:
     Plugin *m_plugin;
@@ -61,6 +382,19 @@ protected:
     float **m_buffer;
     float **m_deinterleave;
     const float **m_forwardPtrs;
+    const float **m_stridedPtrs;
+    bool m_pluginAcceptsStrided;
+    std::vector<float> m_gains;
+
+    const float *getMixGains() const;
+
+    bool canForwardStrided() const;
+    FeatureSet forwardStrided(const float *const *inputBuffers, size_t stride,
+                              RealTime timestamp);
+    void allocateDeinterleaveBuffers();
+
+    FeatureSet processPlugin(const float *const *inputBuffers,
+                             RealTime timestamp, FeatureBuffer *into);
 };
 
 PluginChannelAdapter::PluginChannelAdapter(Plugin *plugin) :
@@ -77,7 +411,9 @@ PluginChannelAdapter::~PluginChannelAdapter()
 bool
 PluginChannelAdapter::initialise(size_t channels, size_t stepSize, size_t blockSize)
 {
-    return m_impl->initialise(channels, stepSize, blockSize);
+    bool ok = m_impl->initialise(channels, stepSize, blockSize);
+    notifyMixGains();
+    return ok;
 }
 
 PluginChannelAdapter::FeatureSet
@@ -87,6 +423,20 @@ PluginChannelAdapter::process(const float *const *inputBuffers,
     return m_impl->process(inputBuffers, timestamp);
 }
 
+void
+PluginChannelAdapter::processInto(const float *const *inputBuffers,
+                                  RealTime timestamp,
+                                  FeatureBuffer &features)
+{
+    m_impl->process(inputBuffers, timestamp, &features);
+}
+
+void
+PluginChannelAdapter::getRemainingFeaturesInto(FeatureBuffer &features)
+{
+    getRemainingPluginFeaturesInto(m_plugin, features);
+}
+
 PluginChannelAdapter::FeatureSet
 PluginChannelAdapter::processInterleaved(const float *inputBuffers,
                                          RealTime timestamp)
@@ -94,6 +444,36 @@ PluginChannelAdapter::processInterleaved(const float *inputBuffers,
     return m_impl->processInterleaved(inputBuffers, timestamp);
 }
 
+bool
+PluginChannelAdapter::supportsStridedInput() const
+{
+    return true;
+}
+
+PluginChannelAdapter::FeatureSet
+PluginChannelAdapter::processStrided(const float *const *inputBuffers,
+                                     size_t stride,
+                                     RealTime timestamp)
+{
+    return m_impl->processStrided(inputBuffers, stride, timestamp);
+}
+
+void
+PluginChannelAdapter::setMixGains(const std::vector<float> &gains)
+{
+    m_impl->setMixGains(gains);
+    notifyMixGains();
+}
+
+void
+PluginChannelAdapter::notifyMixGains()
+{
+    // An input-domain adapter within us must not share its spectra
+    // with one whose plugin is fed a different mix of the same input
+    PluginInputDomainAdapter *ida = getWrapper<PluginInputDomainAdapter>();
+    if (ida) ida->setUpstreamMixGains(m_impl->getMixdownGains());
+}
+
 PluginChannelAdapter::Impl::Impl(Plugin *plugin) :
     m_plugin(plugin),
     m_blockSize(0),
@@ -101,7 +481,9 @@ PluginChannelAdapter::Impl::Impl(Plugin *plugin) :
     m_pluginChannels(0),
     m_buffer(0),
     m_deinterleave(0),
-    m_forwardPtrs(0)
+    m_forwardPtrs(0),
+    m_stridedPtrs(0),
+    m_pluginAcceptsStrided(false)
 {
 }
 
@@ -133,6 +515,8 @@ PluginChannelAdapter::Impl::~Impl()
         delete[] m_forwardPtrs;
         m_forwardPtrs = 0;
     }
+
+    delete[] m_stridedPtrs;
 }
 
 bool
@@ -153,7 +537,7 @@ PluginChannelAdapter::Impl::initialise(size_t channels, size_t stepSize, size_t
             // We need a set of zero-valued buffers to add to the
             // forwarded pointers
             m_buffer = new float*[minch - channels];
-            for (size_t i = 0; i < minch; ++i) {
+            for (size_t i = 0; i < minch - channels; ++i) {
                 m_buffer[i] = new float[blockSize];
                 for (size_t j = 0; j < blockSize; ++j) {
                     m_buffer[i][j] = 0.f;
@@ -184,38 +568,178 @@ PluginChannelAdapter::Impl::initialise(size_t channels, size_t stepSize, size_t
 
         m_pluginChannels = maxch;
 
+        if (!m_gains.empty() && !getMixGains()) {
+            std::cerr << "WARNING: PluginChannelAdapter::initialise: "
+                      << m_gains.size() << " mix gain(s) set for "
+                      << m_inputChannels << " input channels, using mean"
+                      << std::endl;
+        }
+
     } else {
  
 //        std::cerr << "PluginChannelAdapter::initialise: accepting given number of channels (" << m_inputChannels << ")" << std::endl;
         m_pluginChannels = m_inputChannels;
     }
 
+    m_pluginAcceptsStrided = pluginSupportsStridedInput(m_plugin);
+
     return m_plugin->initialise(m_pluginChannels, stepSize, blockSize);
 }
 
+void
+PluginChannelAdapter::Impl::setMixGains(const std::vector<float> &gains)
+{
+    m_gains = gains;
+}
+
+std::vector<float>
+PluginChannelAdapter::Impl::getMixdownGains() const
+{
+    if (m_inputChannels > m_pluginChannels && m_pluginChannels == 1 &&
+        getMixGains()) {
+        return m_gains;
+    }
+    return std::vector<float>();
+}
+
+const float *
+PluginChannelAdapter::Impl::getMixGains() const
+{
+    if (m_gains.empty() || m_gains.size() != m_inputChannels) return 0;
+    return &m_gains[0];
+}
+
 PluginChannelAdapter::FeatureSet
 PluginChannelAdapter::Impl::processInterleaved(const float *inputBuffers,
                                                RealTime timestamp)
 {
-    if (!m_deinterleave) {
-        m_deinterleave = new float *[m_inputChannels];
+    if (m_inputChannels == 1) {
+        // Mono interleaved data is already in the form process() wants
+        return process(&inputBuffers, timestamp);
+    }
+
+    if (m_inputChannels > m_pluginChannels && m_pluginChannels == 1) {
+        // Mix straight from the interleaved data, with no
+        // de-interleaved copy in between
+        mixdownInterleaved(inputBuffers, int(m_inputChannels),
+                           getMixGains(), m_buffer[0], int(m_blockSize));
+        return m_plugin->process(m_buffer, timestamp);
+    }
+
+    if (canForwardStrided()) {
+        // The plugin can read the interleaved data where it is
+        if (!m_stridedPtrs) {
+            m_stridedPtrs = new const float *[m_inputChannels];
+        }
         for (size_t i = 0; i < m_inputChannels; ++i) {
-            m_deinterleave[i] = new float[m_blockSize];
+            m_stridedPtrs[i] = inputBuffers + i;
         }
+        return forwardStrided(m_stridedPtrs, m_inputChannels, timestamp);
     }
 
-    for (size_t i = 0; i < m_inputChannels; ++i) {
+    allocateDeinterleaveBuffers();
+
+    // Channels beyond those the plugin accepts would be discarded
+    // by process(), so we need not de-interleave them
+
+    size_t channels = std::min(m_inputChannels, m_pluginChannels);
+
+    deinterleave(inputBuffers, int(m_inputChannels),
+                 m_deinterleave, int(channels), int(m_blockSize));
+
+    return process(m_deinterleave, timestamp);
+}
+
+PluginChannelAdapter::FeatureSet
+PluginChannelAdapter::Impl::processStrided(const float *const *inputBuffers,
+                                           size_t stride,
+                                           RealTime timestamp)
+{
+    if (stride == 1) {
+        return process(inputBuffers, timestamp);
+    }
+
+    if (canForwardStrided()) {
+        return forwardStrided(inputBuffers, stride, timestamp);
+    }
+
+    // Otherwise gather the channels we need into contiguous buffers:
+    // all of them if mixing down, as far as the plugin's channel
+    // count if not
+
+    allocateDeinterleaveBuffers();
+
+    size_t channels = m_inputChannels;
+    if (m_pluginChannels > 1) {
+        channels = std::min(m_inputChannels, m_pluginChannels);
+    }
+
+    for (size_t i = 0; i < channels; ++i) {
+        const float *in = inputBuffers[i];
+        float *out = m_deinterleave[i];
         for (size_t j = 0; j < m_blockSize; ++j) {
-            m_deinterleave[i][j] = inputBuffers[j * m_inputChannels + i];
+            out[j] = in[j * stride];
         }
     }
 
     return process(m_deinterleave, timestamp);
 }
 
+bool
+PluginChannelAdapter::Impl::canForwardStrided() const
+{
+    // We can pass strided input on unchanged whenever we would
+    // forward the caller's pointers rather than our own buffers: that
+    // is, unless mixing down to mono or padding with empty channels
+
+    if (!m_pluginAcceptsStrided) return false;
+    if (m_inputChannels == 1) return true;
+    return (m_inputChannels >= m_pluginChannels && m_pluginChannels > 1);
+}
+
+PluginChannelAdapter::FeatureSet
+PluginChannelAdapter::Impl::forwardStrided(const float *const *inputBuffers,
+                                           size_t stride,
+                                           RealTime timestamp)
+{
+    if (m_inputChannels < m_pluginChannels) {
+        for (size_t i = 0; i < m_pluginChannels; ++i) {
+            m_forwardPtrs[i] = inputBuffers[0];
+        }
+        return processPluginStrided(m_plugin, m_forwardPtrs, stride,
+                                    timestamp);
+    }
+
+    return processPluginStrided(m_plugin, inputBuffers, stride, timestamp);
+}
+
+void
+PluginChannelAdapter::Impl::allocateDeinterleaveBuffers()
+{
+    if (!m_deinterleave) {
+        m_deinterleave = new float *[m_inputChannels];
+        for (size_t i = 0; i < m_inputChannels; ++i) {
+            m_deinterleave[i] = new float[m_blockSize];
+        }
+    }
+}
+
+PluginChannelAdapter::FeatureSet
+PluginChannelAdapter::Impl::processPlugin(const float *const *inputBuffers,
+                                          RealTime timestamp,
+                                          FeatureBuffer *into)
+{
+    if (into) {
+        processPluginInto(m_plugin, inputBuffers, timestamp, *into);
+        return FeatureSet();
+    }
+    return m_plugin->process(inputBuffers, timestamp);
+}
+
 PluginChannelAdapter::FeatureSet
 PluginChannelAdapter::Impl::process(const float *const *inputBuffers,
-                                    RealTime timestamp)
+                                    RealTime timestamp,
+                                    FeatureBuffer *into)
 {
 //    std::cerr << "PluginChannelAdapter::process: " << m_inputChannels << " -> " << m_pluginChannels << " channels" << std::endl;
 
@@ -234,30 +758,21 @@ PluginChannelAdapter::Impl::process(const float *const *inputBuffers,
             }
         }
 
-        return m_plugin->process(m_forwardPtrs, timestamp);
+        return processPlugin(m_forwardPtrs, timestamp, into);
 
     } else if (m_inputChannels > m_pluginChannels) {
 
         if (m_pluginChannels == 1) {
-            for (size_t j = 0; j < m_blockSize; ++j) {
-                m_buffer[0][j] = inputBuffers[0][j];
-            }
-            for (size_t i = 1; i < m_inputChannels; ++i) {
-                for (size_t j = 0; j < m_blockSize; ++j) {
-                    m_buffer[0][j] += inputBuffers[i][j];
-                }
-            }
-            for (size_t j = 0; j < m_blockSize; ++j) {
-                m_buffer[0][j] /= float(m_inputChannels);
-            }
-            return m_plugin->process(m_buffer, timestamp);
+            mixdownPlanar(inputBuffers, int(m_inputChannels),
+                          getMixGains(), m_buffer[0], int(m_blockSize));
+            return processPlugin(m_buffer, timestamp, into);
         } else {
-            return m_plugin->process(inputBuffers, timestamp);
+            return processPlugin(inputBuffers, timestamp, into);
         }
 
     } else {
 
-        return m_plugin->process(inputBuffers, timestamp);
+        return processPlugin(inputBuffers, timestamp, into);
     }
 }
 
@@ -35,6 +35,7 @@
 */
 
 #include <vamp-hostsdk/PluginHostAdapter.h>
+#include <vamp-hostsdk/PluginWrapper.h>
 #include <cstdlib>
 
 #include "Files.h"
@@ -410,6 +411,67 @@ PluginHostAdapter::getRemainingFeatures()
     return fs;
 }
 
+void
+PluginHostAdapter::processInto(const float *const *inputBuffers,
+                               RealTime timestamp,
+                               HostExt::FeatureBuffer &fb)
+{
+    fb.clear();
+    if (!m_handle) return;
+
+    int sec = timestamp.sec;
+    int nsec = timestamp.nsec;
+    
+    VampFeatureList *features = m_descriptor->process(m_handle,
+                                                      inputBuffers,
+                                                      sec, nsec);
+    
+    convertFeatures(features, fb);
+    m_descriptor->releaseFeatureSet(features);
+}
+
+void
+PluginHostAdapter::getRemainingFeaturesInto(HostExt::FeatureBuffer &fb)
+{
+    fb.clear();
+    if (!m_handle) return;
+    
+    VampFeatureList *features = m_descriptor->getRemainingFeatures(m_handle); 
+
+    convertFeatures(features, fb);
+    m_descriptor->releaseFeatureSet(features);
+}
+
+void
+PluginHostAdapter::convertFeature(const VampFeatureList &list,
+                                  unsigned int j,
+                                  Feature &feature) const
+{
+    const VampFeature &v1 = list.features[j].v1;
+    
+    feature.hasTimestamp = v1.hasTimestamp;
+    feature.timestamp = RealTime(v1.sec, v1.nsec);
+
+    if (m_descriptor->vampApiVersion >= 2) {
+        // the v2 duration data follows all of the v1 features
+        const VampFeatureV2 &v2 = list.features[j + list.featureCount].v2;
+        feature.hasDuration = v2.hasDuration;
+        feature.duration = RealTime(v2.durationSec, v2.durationNsec);
+    } else {
+        feature.hasDuration = false;
+        feature.duration = RealTime::zeroTime;
+    }
+
+    // assign() reuses any storage the feature already has
+    feature.values.assign(v1.values, v1.values + v1.valueCount);
+
+    if (v1.label) {
+        feature.label.assign(v1.label);
+    } else {
+        feature.label.clear();
+    }
+}
+
 void
 PluginHostAdapter::convertFeatures(VampFeatureList *features,
                                    FeatureSet &fs)
@@ -420,45 +482,36 @@ PluginHostAdapter::convertFeatures(VampFeatureList *features,
 
     for (unsigned int i = 0; i < outputs; ++i) {
         
-        VampFeatureList &list = features[i];
-
-        if (list.featureCount > 0) {
-
-            Feature feature;
-            feature.values.reserve(list.features[0].v1.valueCount);
-
-            for (unsigned int j = 0; j < list.featureCount; ++j) {
-
-                feature.hasTimestamp = list.features[j].v1.hasTimestamp;
-                feature.timestamp = RealTime(list.features[j].v1.sec,
-                                             list.features[j].v1.nsec);
-                feature.hasDuration = false;
-
-                if (m_descriptor->vampApiVersion >= 2) {
-                    unsigned int j2 = j + list.featureCount;
-                    feature.hasDuration = list.features[j2].v2.hasDuration;
-                    feature.duration = RealTime(list.features[j2].v2.durationSec,
-                                                list.features[j2].v2.durationNsec);
-                }
+        const VampFeatureList &list = features[i];
+        if (list.featureCount == 0) continue;
 
-                for (unsigned int k = 0; k < list.features[j].v1.valueCount; ++k) {
-                    feature.values.push_back(list.features[j].v1.values[k]);
-                }
+        // Build the features in place, rather than copying each one
+        // in from a temporary
+        
+        FeatureList &target = fs[i];
+        size_t base = target.size();
+        target.resize(base + list.featureCount);
+        
+        for (unsigned int j = 0; j < list.featureCount; ++j) {
+            convertFeature(list, j, target[base + j]);
+        }
+    }
+}
 
-                if (list.features[j].v1.label) {
-                    feature.label = list.features[j].v1.label;
-                }
+void
+PluginHostAdapter::convertFeatures(VampFeatureList *features,
+                                   HostExt::FeatureBuffer &fb)
+{
+    if (!features) return;
 
-                fs[i].push_back(feature);
+    unsigned int outputs = m_descriptor->getOutputCount(m_handle);
 
-                if (list.features[j].v1.valueCount > 0) {
-                    feature.values.clear();
-                }
+    for (unsigned int i = 0; i < outputs; ++i) {
+        
+        const VampFeatureList &list = features[i];
 
-                if (list.features[j].v1.label) {
-                    feature.label = "";
-                }
-            }
+        for (unsigned int j = 0; j < list.featureCount; ++j) {
+            convertFeature(list, j, fb.addFeature(int(i)));
         }
     }
 }
@@ -40,6 +40,10 @@
 #include <vamp-hostsdk/PluginInputDomainAdapter.h>
 
 #include <cmath>
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <vector>
 
 #include "Window.h"
 
@@ -49,6 +53,8 @@
 #include <string.h>
 #include <limits.h>
 
+#include "../vamp-sdk/FFTsimd.h"
+
 _VAMP_SDK_HOSTSPACE_BEGIN(PluginInputDomainAdapter.cpp)
 
 #include "../vamp-sdk/FFTimpl.cpp"
@@ -57,6 +63,344 @@ namespace Vamp {
 
 namespace HostExt {
 
+class SpectralSource::Impl
+{
+public:
+    /**
+     * Adapters whose spectra can be shared have equal keys.
+     */
+    struct Key {
+        int channels;
+        int blockSize;
+        int windowType;
+        bool shiftData;
+        int stepSize; // only used for ShiftData, otherwise zero
+        std::vector<float> mixGains; // see setUpstreamMixGains
+
+        bool operator<(const Key &k) const {
+            if (channels != k.channels) return channels < k.channels;
+            if (blockSize != k.blockSize) return blockSize < k.blockSize;
+            if (windowType != k.windowType) return windowType < k.windowType;
+            if (shiftData != k.shiftData) return shiftData < k.shiftData;
+            if (stepSize != k.stepSize) return stepSize < k.stepSize;
+            return mixGains < k.mixGains;
+        }
+    };
+
+    /**
+     * The spectra for one frame, with their polar form calculated
+     * only if asked for.
+     */
+    struct Frame {
+        Frame(int channels, int blockSize);
+        ~Frame();
+
+        /**
+         * Call after writing new spectra, to invalidate the polar form.
+         */
+        void spectraChanged();
+
+        /**
+         * Calculate the magnitudes, and the phases as well if
+         * requested, unless they are already up to date.
+         */
+        void calculatePolar(bool withPhases);
+
+        int channels;
+        int blockSize;
+        RealTime timestamp;
+        float **spectra;
+        float **magnitudes;
+        float **phases;
+        bool haveMagnitudes;
+        bool havePhases;
+    };
+
+    struct Consumer {
+        Consumer() : started(false) { }
+        bool started;
+        RealTime position;
+    };
+
+    /**
+     * The spectra retained for one group of adapters with equal keys,
+     * in timestamp order.
+     */
+    struct Slot {
+        Key key;
+        size_t maxFrames;
+        std::deque<Frame *> frames;
+        std::vector<Frame *> spare;
+        std::map<const void *, Consumer> consumers;
+    };
+
+    Impl() { }
+    ~Impl();
+
+    Slot *attach(const void *consumer, const Key &key);
+    void detach(const void *consumer, Slot *slot);
+
+    /**
+     * Record that the given consumer is now at the given timestamp,
+     * and return the frame for it, or 0 if it has not been
+     * calculated.
+     */
+    Frame *lookup(Slot *slot, const void *consumer, RealTime timestamp);
+
+    /**
+     * Return a frame for the caller to fill with the spectra for the
+     * given timestamp, which lookup() has just failed to find. The
+     * frame remains valid at least until the next call to the source.
+     */
+    Frame *insert(Slot *slot, RealTime timestamp);
+
+    void clear(Slot *slot);
+    void reset();
+
+private:
+    std::map<Key, Slot *> m_slots;
+
+    void prune(Slot *slot);
+    std::deque<Frame *>::iterator find(Slot *slot, RealTime timestamp);
+};
+
+SpectralSource::SpectralSource() :
+    m_impl(new Impl)
+{
+}
+
+SpectralSource::~SpectralSource()
+{
+    delete m_impl;
+}
+
+void
+SpectralSource::reset()
+{
+    m_impl->reset();
+}
+
+SpectralSource::Impl::~Impl()
+{
+    for (std::map<Key, Slot *>::iterator i = m_slots.begin();
+         i != m_slots.end(); ++i) {
+        clear(i->second);
+        for (size_t j = 0; j < i->second->spare.size(); ++j) {
+            delete i->second->spare[j];
+        }
+        delete i->second;
+    }
+}
+
+SpectralSource::Impl::Slot *
+SpectralSource::Impl::attach(const void *consumer, const Key &key)
+{
+    Slot *slot = 0;
+    
+    std::map<Key, Slot *>::iterator i = m_slots.find(key);
+    if (i != m_slots.end()) {
+        slot = i->second;
+    } else {
+        slot = new Slot;
+        slot->key = key;
+        // Retain up to 32MB of spectra, but always at least a few
+        // frames so that adapters called in turn can share
+        size_t frameBytes = size_t(key.channels) * (key.blockSize + 2) * sizeof(float);
+        slot->maxFrames = std::max(size_t(16), (32 << 20) / frameBytes);
+        m_slots[key] = slot;
+    }
+
+    slot->consumers[consumer] = Consumer();
+    return slot;
+}
+
+void
+SpectralSource::Impl::detach(const void *consumer, Slot *slot)
+{
+    slot->consumers.erase(consumer);
+
+    if (slot->consumers.empty()) {
+        clear(slot);
+        for (size_t j = 0; j < slot->spare.size(); ++j) {
+            delete slot->spare[j];
+        }
+        m_slots.erase(slot->key);
+        delete slot;
+    }
+}
+
+std::deque<SpectralSource::Impl::Frame *>::iterator
+SpectralSource::Impl::find(Slot *slot, RealTime timestamp)
+{
+    // Frames are in timestamp order and usually requested close to
+    // the end, so search backwards
+    std::deque<Frame *>::iterator i = slot->frames.end();
+    while (i != slot->frames.begin()) {
+        --i;
+        if (!((*i)->timestamp > timestamp)) {
+            if ((*i)->timestamp < timestamp) ++i;
+            return i;
+        }
+    }
+    return i;
+}
+
+SpectralSource::Impl::Frame *
+SpectralSource::Impl::lookup(Slot *slot, const void *consumer, RealTime timestamp)
+{
+    Consumer &c = slot->consumers[consumer];
+    c.started = true;
+    c.position = timestamp;
+
+    prune(slot);
+
+    std::deque<Frame *>::iterator i = find(slot, timestamp);
+    if (i != slot->frames.end() && (*i)->timestamp == timestamp) {
+        return *i;
+    }
+    return 0;
+}
+
+SpectralSource::Impl::Frame *
+SpectralSource::Impl::insert(Slot *slot, RealTime timestamp)
+{
+    Frame *frame = 0;
+    
+    if (slot->frames.size() >= slot->maxFrames) {
+        frame = slot->frames.front();
+        slot->frames.pop_front();
+    } else if (!slot->spare.empty()) {
+        frame = slot->spare.back();
+        slot->spare.pop_back();
+    } else {
+        frame = new Frame(slot->key.channels, slot->key.blockSize);
+    }
+
+    frame->timestamp = timestamp;
+    slot->frames.insert(find(slot, timestamp), frame);
+    return frame;
+}
+
+void
+SpectralSource::Impl::prune(Slot *slot)
+{
+    // Discard frames that every consumer has moved beyond. Until all
+    // consumers have started, we don't know where they will begin
+    
+    RealTime earliest;
+    bool first = true;
+
+    for (std::map<const void *, Consumer>::const_iterator i =
+             slot->consumers.begin(); i != slot->consumers.end(); ++i) {
+        if (!i->second.started) return;
+        if (first || i->second.position < earliest) {
+            earliest = i->second.position;
+            first = false;
+        }
+    }
+
+    while (!slot->frames.empty() &&
+           slot->frames.front()->timestamp < earliest) {
+        slot->spare.push_back(slot->frames.front());
+        slot->frames.pop_front();
+    }
+}
+
+void
+SpectralSource::Impl::clear(Slot *slot)
+{
+    while (!slot->frames.empty()) {
+        slot->spare.push_back(slot->frames.front());
+        slot->frames.pop_front();
+    }
+}
+
+void
+SpectralSource::Impl::reset()
+{
+    for (std::map<Key, Slot *>::iterator i = m_slots.begin();
+         i != m_slots.end(); ++i) {
+        clear(i->second);
+    }
+}
+
+SpectralSource::Impl::Frame::Frame(int channelCount, int size) :
+    channels(channelCount),
+    blockSize(size),
+    magnitudes(0),
+    phases(0),
+    haveMagnitudes(false),
+    havePhases(false)
+{
+    spectra = new float *[channels];
+    for (int c = 0; c < channels; ++c) {
+        spectra[c] = new float[blockSize + 2];
+    }
+}
+
+SpectralSource::Impl::Frame::~Frame()
+{
+    for (int c = 0; c < channels; ++c) {
+        delete[] spectra[c];
+        if (magnitudes) delete[] magnitudes[c];
+        if (phases) delete[] phases[c];
+    }
+    delete[] spectra;
+    delete[] magnitudes;
+    delete[] phases;
+}
+
+void
+SpectralSource::Impl::Frame::spectraChanged()
+{
+    haveMagnitudes = false;
+    havePhases = false;
+}
+
+void
+SpectralSource::Impl::Frame::calculatePolar(bool withPhases)
+{
+    const int bins = blockSize/2 + 1;
+
+    if (!haveMagnitudes) {
+        if (!magnitudes) {
+            magnitudes = new float *[channels];
+            for (int c = 0; c < channels; ++c) {
+                magnitudes[c] = new float[bins];
+            }
+        }
+        for (int c = 0; c < channels; ++c) {
+#ifdef VAMP_KISS_FFT_SIMD
+            VampKissSIMD::magnitudes(spectra[c], magnitudes[c], bins);
+#else
+            const float *s = spectra[c];
+            float *m = magnitudes[c];
+            for (int i = 0; i < bins; ++i) {
+                m[i] = sqrtf(s[i*2] * s[i*2] + s[i*2+1] * s[i*2+1]);
+            }
+#endif
+        }
+        haveMagnitudes = true;
+    }
+
+    if (withPhases && !havePhases) {
+        if (!phases) {
+            phases = new float *[channels];
+            for (int c = 0; c < channels; ++c) {
+                phases[c] = new float[bins];
+            }
+        }
+        for (int c = 0; c < channels; ++c) {
+            const float *s = spectra[c];
+            float *p = phases[c];
+            for (int i = 0; i < bins; ++i) {
+                p[i] = atan2f(s[i*2+1], s[i*2]);
+            }
+        }
+        havePhases = true;
+    }
+}
+
 class PluginInputDomainAdapter::Impl
 {
 public:
@@ -69,7 +413,10 @@ public:
     size_t getPreferredStepSize() const;
     size_t getPreferredBlockSize() const;
 
-    FeatureSet process(const float *const *inputBuffers, RealTime timestamp);
+    bool supportsStridedInput() const;
+    FeatureSet process(const float *const *inputBuffers, size_t stride,
+                       RealTime timestamp, FeatureBuffer *into);
+    void getRemainingFeaturesInto(FeatureBuffer &features);
 
     void setProcessTimestampMethod(ProcessTimestampMethod m);
     ProcessTimestampMethod getProcessTimestampMethod() const;
@@ -79,28 +426,58 @@ public:
     WindowType getWindowType() const;
     void setWindowType(WindowType type);
 
+    void setSpectralSource(SpectralSource *source);
+    SpectralSource *getSpectralSource() const;
+    void setUpstreamMixGains(const std::vector<float> &gains);
+
+    PolarOutput getPolarOutput() const;
+    void setPolarOutput(PolarOutput output);
+
+    const float *const *getMagnitudes() const;
+    const float *const *getPhases() const;
+
 protected:
+    typedef SpectralSource::Impl::Frame Frame;
+    
     Plugin *m_plugin;
     float m_inputSampleRate;
     int m_channels;
     int m_stepSize;
     int m_blockSize;
-    float **m_freqbuf;
-    Kiss::vamp_kiss_fft_scalar *m_ri;
+    Frame *m_frame;
+    Frame *m_current;
+    float *m_ri;
 
     WindowType m_windowType;
-    typedef Window<Kiss::vamp_kiss_fft_scalar> W;
+    typedef Window<float> W;
     W *m_window;
 
     ProcessTimestampMethod m_method;
     int m_processCount;
     float **m_shiftBuffers;
+    int m_shiftStart;
+
+    KissFloat::vamp_kiss_fftr_cfg m_cfg;
+
+    SpectralSource *m_source;
+    SpectralSource::Impl::Slot *m_slot;
+    std::vector<float> m_mixGains;
 
-    Kiss::vamp_kiss_fftr_cfg m_cfg;
-    Kiss::vamp_kiss_fft_cpx *m_cbuf;
+    PolarOutput m_polar;
 
-    FeatureSet processShiftingTimestamp(const float *const *inputBuffers, RealTime timestamp);
-    FeatureSet processShiftingData(const float *const *inputBuffers, RealTime timestamp);
+    void transformChannels(Frame *frame);
+    void deleteShiftBuffers();
+
+    static void copyInput(float *dst, const float *src, int stride, int n);
+
+    void attachToSource();
+    void detachFromSource();
+    Frame *getFrame(RealTime timestamp, bool &fill);
+    FeatureSet processFrame(Frame *frame, RealTime timestamp,
+                            FeatureBuffer *into);
+
+    FeatureSet processShiftingTimestamp(const float *const *inputBuffers, int stride, RealTime timestamp, FeatureBuffer *into);
+    FeatureSet processShiftingData(const float *const *inputBuffers, int stride, RealTime timestamp, FeatureBuffer *into);
 
     size_t makeBlockSizeAcceptable(size_t) const;
     
@@ -151,7 +528,35 @@ PluginInputDomainAdapter::getPreferredBlockSize() const
 Plugin::FeatureSet
 PluginInputDomainAdapter::process(const float *const *inputBuffers, RealTime timestamp)
 {
-    return m_impl->process(inputBuffers, timestamp);
+    return m_impl->process(inputBuffers, 1, timestamp, 0);
+}
+
+void
+PluginInputDomainAdapter::processInto(const float *const *inputBuffers,
+                                      RealTime timestamp,
+                                      FeatureBuffer &features)
+{
+    m_impl->process(inputBuffers, 1, timestamp, &features);
+}
+
+void
+PluginInputDomainAdapter::getRemainingFeaturesInto(FeatureBuffer &features)
+{
+    m_impl->getRemainingFeaturesInto(features);
+}
+
+bool
+PluginInputDomainAdapter::supportsStridedInput() const
+{
+    return m_impl->supportsStridedInput();
+}
+
+Plugin::FeatureSet
+PluginInputDomainAdapter::processStrided(const float *const *inputBuffers,
+                                         size_t stride,
+                                         RealTime timestamp)
+{
+    return m_impl->process(inputBuffers, stride, timestamp, 0);
 }
 
 void
@@ -184,6 +589,48 @@ PluginInputDomainAdapter::setWindowType(WindowType w)
     m_impl->setWindowType(w);
 }
 
+void
+PluginInputDomainAdapter::setSpectralSource(SpectralSource *source)
+{
+    m_impl->setSpectralSource(source);
+}
+
+SpectralSource *
+PluginInputDomainAdapter::getSpectralSource() const
+{
+    return m_impl->getSpectralSource();
+}
+
+void
+PluginInputDomainAdapter::setUpstreamMixGains(const std::vector<float> &gains)
+{
+    m_impl->setUpstreamMixGains(gains);
+}
+
+PluginInputDomainAdapter::PolarOutput
+PluginInputDomainAdapter::getPolarOutput() const
+{
+    return m_impl->getPolarOutput();
+}
+
+void
+PluginInputDomainAdapter::setPolarOutput(PolarOutput output)
+{
+    m_impl->setPolarOutput(output);
+}
+
+const float *const *
+PluginInputDomainAdapter::getMagnitudes() const
+{
+    return m_impl->getMagnitudes();
+}
+
+const float *const *
+PluginInputDomainAdapter::getPhases() const
+{
+    return m_impl->getPhases();
+}
+
 
 PluginInputDomainAdapter::Impl::Impl(Plugin *plugin, float inputSampleRate) :
     m_plugin(plugin),
@@ -191,15 +638,19 @@ PluginInputDomainAdapter::Impl::Impl(Plugin *plugin, float inputSampleRate) :
     m_channels(0),
     m_stepSize(0),
     m_blockSize(0),
-    m_freqbuf(0),
+    m_frame(0),
+    m_current(0),
     m_ri(0),
     m_windowType(HanningWindow),
     m_window(0),
     m_method(ShiftTimestamp),
     m_processCount(0),
     m_shiftBuffers(0),
+    m_shiftStart(0),
     m_cfg(0),
-    m_cbuf(0)
+    m_source(0),
+    m_slot(0),
+    m_polar(NoPolarOutput)
 {
 }
 
@@ -207,29 +658,32 @@ PluginInputDomainAdapter::Impl::~Impl()
 {
     // the adapter will delete the plugin
 
-    if (m_shiftBuffers) {
-        for (int c = 0; c < m_channels; ++c) {
-            delete[] m_shiftBuffers[c];
-        }
-        delete[] m_shiftBuffers;
-    }
+    detachFromSource();
+    deleteShiftBuffers();
 
     if (m_channels > 0) {
-        for (int c = 0; c < m_channels; ++c) {
-            delete[] m_freqbuf[c];
-        }
-        delete[] m_freqbuf;
+        delete m_frame;
         delete[] m_ri;
         if (m_cfg) {
-            Kiss::vamp_kiss_fftr_free(m_cfg);
+            KissFloat::vamp_kiss_fftr_free(m_cfg);
             m_cfg = 0;
-            delete[] m_cbuf;
-            m_cbuf = 0;
         }
         delete m_window;
     }
 }
 
+void
+PluginInputDomainAdapter::Impl::deleteShiftBuffers()
+{
+    if (m_shiftBuffers) {
+        for (int c = 0; c < m_channels; ++c) {
+            delete[] m_shiftBuffers[c];
+        }
+        delete[] m_shiftBuffers;
+        m_shiftBuffers = 0;
+    }
+}
+
 // for some visual studii apparently
 #ifndef M_PI
 #define M_PI 3.14159265358979232846
@@ -257,17 +711,14 @@ PluginInputDomainAdapter::Impl::initialise(size_t channels, size_t stepSize, siz
         return false;
     }
 
+    deleteShiftBuffers();
+
     if (m_channels > 0) {
-        for (int c = 0; c < m_channels; ++c) {
-            delete[] m_freqbuf[c];
-        }
-        delete[] m_freqbuf;
+        delete m_frame;
         delete[] m_ri;
         if (m_cfg) {
-            Kiss::vamp_kiss_fftr_free(m_cfg);
+            KissFloat::vamp_kiss_fftr_free(m_cfg);
             m_cfg = 0;
-            delete[] m_cbuf;
-            m_cbuf = 0;
         }
         delete m_window;
     }
@@ -276,19 +727,18 @@ PluginInputDomainAdapter::Impl::initialise(size_t channels, size_t stepSize, siz
     m_blockSize = int(blockSize);
     m_channels = int(channels);
 
-    m_freqbuf = new float *[m_channels];
-    for (int c = 0; c < m_channels; ++c) {
-        m_freqbuf[c] = new float[m_blockSize + 2];
-    }
-    m_ri = new Kiss::vamp_kiss_fft_scalar[m_blockSize];
+    m_frame = new Frame(m_channels, m_blockSize);
+    m_current = 0;
+    m_ri = new float[m_channels * m_blockSize];
 
     m_window = new W(convertType(m_windowType), m_blockSize);
 
-    m_cfg = Kiss::vamp_kiss_fftr_alloc(m_blockSize, false, 0, 0);
-    m_cbuf = new Kiss::vamp_kiss_fft_cpx[m_blockSize/2+1];
+    m_cfg = KissFloat::vamp_kiss_fftr_alloc(m_blockSize, false, 0, 0);
 
     m_processCount = 0;
 
+    attachToSource();
+
     return m_plugin->initialise(channels, stepSize, m_blockSize);
 }
 
@@ -296,9 +746,143 @@ void
 PluginInputDomainAdapter::Impl::reset()
 {
     m_processCount = 0;
+    m_current = 0;
+    if (m_slot) m_source->m_impl->clear(m_slot);
     m_plugin->reset();
 }
 
+void
+PluginInputDomainAdapter::Impl::setSpectralSource(SpectralSource *source)
+{
+    if (source == m_source) return;
+    detachFromSource();
+    m_source = source;
+    attachToSource();
+}
+
+SpectralSource *
+PluginInputDomainAdapter::Impl::getSpectralSource() const
+{
+    return m_source;
+}
+
+void
+PluginInputDomainAdapter::Impl::setUpstreamMixGains(const std::vector<float> &gains)
+{
+    if (gains == m_mixGains) return;
+    m_mixGains = gains;
+    if (m_slot) attachToSource();
+}
+
+void
+PluginInputDomainAdapter::Impl::attachToSource()
+{
+    // Called whenever anything that affects our spectra changes, so
+    // as to move to the group of adapters that calculate the same
+    // ones. Nothing to share until we have been initialised for the
+    // frequency domain
+    
+    if (m_slot) {
+        m_source->m_impl->detach(this, m_slot);
+        m_slot = 0;
+        m_current = 0;
+    }
+    
+    if (!m_source || !m_window) return;
+
+    SpectralSource::Impl::Key key;
+    key.channels = m_channels;
+    key.blockSize = m_blockSize;
+    key.windowType = int(m_windowType);
+    key.shiftData = (m_method == ShiftData);
+    key.stepSize = (key.shiftData ? m_stepSize : 0);
+    key.mixGains = m_mixGains;
+
+    m_slot = m_source->m_impl->attach(this, key);
+}
+
+void
+PluginInputDomainAdapter::Impl::detachFromSource()
+{
+    if (m_slot) {
+        m_source->m_impl->detach(this, m_slot);
+        m_slot = 0;
+        m_current = 0;
+    }
+    m_source = 0;
+}
+
+PluginInputDomainAdapter::Impl::Frame *
+PluginInputDomainAdapter::Impl::getFrame(RealTime timestamp, bool &fill)
+{
+    // Return the frame to pass to the plugin for the given
+    // (unadjusted) input timestamp. If fill is set on return, the
+    // caller must calculate its spectra first; otherwise another
+    // adapter sharing our source already has
+    
+    fill = true;
+    
+    if (!m_slot) return m_frame;
+
+    Frame *frame = m_source->m_impl->lookup(m_slot, this, timestamp);
+    if (frame) {
+        fill = false;
+        return frame;
+    }
+    
+    return m_source->m_impl->insert(m_slot, timestamp);
+}
+
+Plugin::FeatureSet
+PluginInputDomainAdapter::Impl::processFrame(Frame *frame, RealTime timestamp,
+                                             FeatureBuffer *into)
+{
+    if (m_polar != NoPolarOutput) {
+        frame->calculatePolar(m_polar == MagnitudeAndPhaseOutput);
+    }
+
+    m_current = frame;
+
+    if (into) {
+        processPluginInto(m_plugin, frame->spectra, timestamp, *into);
+        return FeatureSet();
+    }
+    
+    return m_plugin->process(frame->spectra, timestamp);
+}
+
+void
+PluginInputDomainAdapter::Impl::getRemainingFeaturesInto(FeatureBuffer &features)
+{
+    getRemainingPluginFeaturesInto(m_plugin, features);
+}
+
+PluginInputDomainAdapter::PolarOutput
+PluginInputDomainAdapter::Impl::getPolarOutput() const
+{
+    return m_polar;
+}
+
+void
+PluginInputDomainAdapter::Impl::setPolarOutput(PolarOutput output)
+{
+    m_polar = output;
+}
+
+const float *const *
+PluginInputDomainAdapter::Impl::getMagnitudes() const
+{
+    if (m_polar == NoPolarOutput || !m_current) return 0;
+    return m_current->magnitudes;
+}
+
+const float *const *
+PluginInputDomainAdapter::Impl::getPhases() const
+{
+    if (m_polar != MagnitudeAndPhaseOutput || !m_current) return 0;
+    return m_current->phases;
+}
+
 size_t
 PluginInputDomainAdapter::Impl::getPreferredStepSize() const
 {
@@ -362,7 +946,9 @@ PluginInputDomainAdapter::Impl::getTimestampAdjustment() const
 void
 PluginInputDomainAdapter::Impl::setProcessTimestampMethod(ProcessTimestampMethod m)
 {
+    if (m_method == m) return;
     m_method = m;
+    if (m_slot) attachToSource();
 }
 
 PluginInputDomainAdapter::ProcessTimestampMethod
@@ -380,6 +966,7 @@ PluginInputDomainAdapter::Impl::setWindowType(WindowType t)
         delete m_window;
         m_window = new W(convertType(m_windowType), m_blockSize);
     }
+    if (m_slot) attachToSource();
 }
 
 PluginInputDomainAdapter::WindowType
@@ -411,29 +998,79 @@ PluginInputDomainAdapter::Impl::convertType(WindowType t) const
     }
 }
 
+bool
+PluginInputDomainAdapter::Impl::supportsStridedInput() const
+{
+    // We always copy frequency-domain input into our own buffers, so
+    // can read it from anywhere; time-domain input goes straight to
+    // the plugin, which would have to accept it itself
+
+    if (m_plugin->getInputDomain() == TimeDomain) {
+        return pluginSupportsStridedInput(m_plugin);
+    }
+    return true;
+}
+
 Plugin::FeatureSet
 PluginInputDomainAdapter::Impl::process(const float *const *inputBuffers,
-                                        RealTime timestamp)
+                                        size_t stride,
+                                        RealTime timestamp,
+                                        FeatureBuffer *into)
 {
     if (m_plugin->getInputDomain() == TimeDomain) {
-        return m_plugin->process(inputBuffers, timestamp);
+        if (stride == 1) {
+            if (into) {
+                processPluginInto(m_plugin, inputBuffers, timestamp, *into);
+                return FeatureSet();
+            }
+            return m_plugin->process(inputBuffers, timestamp);
+        }
+        return processPluginStrided(m_plugin, inputBuffers, stride, timestamp);
     }
 
     if (m_method == ShiftTimestamp || m_method == NoShift) {
-        return processShiftingTimestamp(inputBuffers, timestamp);
+        return processShiftingTimestamp(inputBuffers, int(stride), timestamp,
+                                        into);
     } else {
-        return processShiftingData(inputBuffers, timestamp);
+        return processShiftingData(inputBuffers, int(stride), timestamp, into);
     }
 }
 
+void
+PluginInputDomainAdapter::Impl::transformChannels(Frame *frame)
+{
+    // The callers window all channels into m_ri first, and the
+    // channels are then transformed one after another, so that the
+    // window and the FFT's twiddles each stay in cache across the
+    // whole set of channels rather than displacing one another for
+    // every channel. The window is written straight into its
+    // FFT-shifted position, so each frame is read only once before
+    // the FFT. The float KissFFT complex type has the same layout as
+    // the interleaved output the plugin expects, so the FFT's final
+    // stage writes straight into the spectra passed to the plugin.
+
+    for (int c = 0; c < m_channels; ++c) {
+        KissFloat::vamp_kiss_fftr
+            (m_cfg, m_ri + c * m_blockSize,
+             (KissFloat::vamp_kiss_fft_cpx *)frame->spectra[c]);
+    }
+
+    frame->spectraChanged();
+}
+
 Plugin::FeatureSet
 PluginInputDomainAdapter::Impl::processShiftingTimestamp(const float *const *inputBuffers,
-                                                         RealTime timestamp)
+                                                         int stride,
+                                                         RealTime timestamp,
+                                                         FeatureBuffer *into)
 {
     unsigned int roundedRate = 1;
     if (m_inputSampleRate > 0.f) {
         roundedRate = (unsigned int)round(m_inputSampleRate);
     }
+
+    bool fill = true;
+    Frame *frame = getFrame(timestamp, fill);
     
     if (m_method == ShiftTimestamp) {
         // we may need to add one nsec if timestamp +
@@ -446,77 +1083,140 @@ PluginInputDomainAdapter::Impl::processShiftingTimestamp(const float *const *inp
         }
     }
 
-    for (int c = 0; c < m_channels; ++c) {
-
-        m_window->cut(inputBuffers[c], m_ri);
-
-        for (int i = 0; i < m_blockSize/2; ++i) {
-            // FFT shift
-            Kiss::vamp_kiss_fft_scalar value = m_ri[i];
-            m_ri[i] = m_ri[i + m_blockSize/2];
-            m_ri[i + m_blockSize/2] = value;
+    if (fill) {
+        for (int c = 0; c < m_channels; ++c) {
+            if (stride == 1) {
+                m_window->cutShifted(inputBuffers[c], m_ri + c * m_blockSize);
+            } else {
+                m_window->cutShifted(inputBuffers[c], stride,
+                                     m_ri + c * m_blockSize);
+            }
         }
+        transformChannels(frame);
+    }
 
-        Kiss::vamp_kiss_fftr(m_cfg, m_ri, m_cbuf);
-        
-        for (int i = 0; i <= m_blockSize/2; ++i) {
-            m_freqbuf[c][i * 2] = float(m_cbuf[i].r);
-            m_freqbuf[c][i * 2 + 1] = float(m_cbuf[i].i);
+    return processFrame(frame, timestamp, into);
+}
+
+void
+PluginInputDomainAdapter::Impl::copyInput(float *dst, const float *src,
+                                          int stride, int n)
+{
+    if (stride == 1) {
+        memcpy(dst, src, n * sizeof(float));
+    } else {
+        for (int i = 0; i < n; ++i) {
+            dst[i] = src[i * stride];
         }
     }
-
-    return m_plugin->process(m_freqbuf, timestamp);
 }
 
 Plugin::FeatureSet
 PluginInputDomainAdapter::Impl::processShiftingData(const float *const *inputBuffers,
-                                                    RealTime timestamp)
+                                                    int stride,
+                                                    RealTime timestamp,
+                                                    FeatureBuffer *into)
 {
+    // The frame passed to the plugin is the half block of input that
+    // preceded this call, followed by the first half of this call's
+    // input. That preceding half block is kept for each channel in
+    // m_shiftBuffers, a circular buffer of hs samples starting at
+    // m_shiftStart. Each buffer is stored twice over, so that the
+    // history can always be read as hs contiguous samples from
+    // m_shiftBuffers[c] + m_shiftStart without any wraparound. That
+    // lets us update it by writing only the samples that change
+    // rather than shifting the whole thing along at every step.
+
+    const int hs = m_blockSize/2;
+    const size_t bytes = sizeof(float);
+    
     if (m_processCount == 0) {
         if (!m_shiftBuffers) {
             m_shiftBuffers = new float *[m_channels];
             for (int c = 0; c < m_channels; ++c) {
-                m_shiftBuffers[c] = new float[m_blockSize + m_blockSize/2];
+                m_shiftBuffers[c] = new float[hs * 2];
             }
         }
         for (int c = 0; c < m_channels; ++c) {
-            for (int i = 0; i < m_blockSize + m_blockSize/2; ++i) {
-                m_shiftBuffers[c][i] = 0.f;
-            }
+            memset(m_shiftBuffers[c], 0, hs * 2 * bytes);
         }
+        m_shiftStart = 0;
     }
 
-    for (int c = 0; c < m_channels; ++c) {
-        for (int i = m_stepSize; i < m_blockSize + m_blockSize/2; ++i) {
-            m_shiftBuffers[c][i - m_stepSize] = m_shiftBuffers[c][i];
-        }
-        for (int i = 0; i < m_blockSize; ++i) {
-            m_shiftBuffers[c][i + m_blockSize/2] = inputBuffers[c][i];
+    // Even if another adapter has already calculated this frame's
+    // spectra for us, we still have to keep our history up to date
+    // in case the next frame is not shared
+
+    bool fill = true;
+    Frame *frame = getFrame(timestamp, fill);
+
+    if (fill) {
+        for (int c = 0; c < m_channels; ++c) {
+            if (stride == 1) {
+                m_window->cutShifted(m_shiftBuffers[c] + m_shiftStart,
+                                     inputBuffers[c],
+                                     m_ri + c * m_blockSize);
+            } else {
+                m_window->cutShifted(m_shiftBuffers[c] + m_shiftStart,
+                                     inputBuffers[c], stride,
+                                     m_ri + c * m_blockSize);
+            }
         }
     }
 
-    for (int c = 0; c < m_channels; ++c) {
+    // The history for the next call is the last hs samples of this
+    // call's history followed by the first m_stepSize samples of its
+    // input
 
-        m_window->cut(m_shiftBuffers[c], m_ri);
+    if (m_stepSize < hs) {
 
-        for (int i = 0; i < m_blockSize/2; ++i) {
-            // FFT shift
-            Kiss::vamp_kiss_fft_scalar value = m_ri[i];
-            m_ri[i] = m_ri[i + m_blockSize/2];
-            m_ri[i + m_blockSize/2] = value;
+        // Overwrite the oldest m_stepSize samples, in both copies,
+        // and advance the start past them
+        
+        int n0 = std::min(m_stepSize, hs - m_shiftStart);
+        int n1 = m_stepSize - n0;
+        
+        for (int c = 0; c < m_channels; ++c) {
+            float *buf = m_shiftBuffers[c];
+            const float *in = inputBuffers[c];
+            copyInput(buf + m_shiftStart, in, stride, n0);
+            memcpy(buf + m_shiftStart + hs, buf + m_shiftStart, n0 * bytes);
+            copyInput(buf, in + n0 * stride, stride, n1);
+            memcpy(buf + hs, buf, n1 * bytes);
         }
 
-        Kiss::vamp_kiss_fftr(m_cfg, m_ri, m_cbuf);
-        
-        for (int i = 0; i <= m_blockSize/2; ++i) {
-            m_freqbuf[c][i * 2] = float(m_cbuf[i].r);
-            m_freqbuf[c][i * 2 + 1] = float(m_cbuf[i].i);
+        m_shiftStart = (m_shiftStart + m_stepSize) % hs;
+
+    } else {
+
+        // The whole history comes from this call's input, unless the
+        // step exceeds the block size, in which case there is no
+        // input for the end of it and we keep what was there before
+
+        int fromInput = std::min(hs, m_blockSize + hs - m_stepSize);
+
+        for (int c = 0; c < m_channels; ++c) {
+            float *buf = m_shiftBuffers[c];
+            if (fromInput < hs) {
+                memmove(buf, buf + m_shiftStart, hs * bytes);
+            }
+            if (fromInput > 0) {
+                copyInput(buf, inputBuffers[c] + (m_stepSize - hs) * stride,
+                          stride, fromInput);
+            }
+            memcpy(buf + hs, buf, hs * bytes);
         }
+
+        m_shiftStart = 0;
+    }
+
+    if (fill) {
+        transformChannels(frame);
     }
 
     ++m_processCount;
 
-    return m_plugin->process(m_freqbuf, timestamp);
+    return processFrame(frame, timestamp, into);
 }
 
 }
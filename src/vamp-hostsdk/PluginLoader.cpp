@@ -45,6 +45,8 @@
 #include "Files.h"
 
 #include <fstream>
+#include <sstream>
+#include <algorithm>
 
 using namespace std;
 
@@ -66,7 +68,8 @@ public:
 
     Plugin *loadPlugin(PluginKey key,
                        float inputSampleRate,
-                       int adapterFlags);
+                       int adapterFlags,
+                       SpectralSource *source);
     
     PluginKey composePluginKey(string libraryName, string identifier);
 
@@ -74,13 +77,24 @@ public:
 
     string getLibraryPathForPlugin(PluginKey key);
 
+    void setLibraryCacheEnabled(bool enabled);
+
     static void setInstanceToClean(PluginLoader *instance);
 
 protected:
-    class PluginDeletionNotifyAdapter : public PluginWrapper {
+    class PluginDeletionNotifyAdapter : public PluginWrapper,
+                                        public FeatureBufferProcessor {
     public:
         PluginDeletionNotifyAdapter(Plugin *plugin, Impl *loader);
         virtual ~PluginDeletionNotifyAdapter();
+        void processInto(const float *const *inputBuffers,
+                         RealTime timestamp,
+                         FeatureBuffer &features) {
+            processPluginInto(m_plugin, inputBuffers, timestamp, features);
+        }
+        void getRemainingFeaturesInto(FeatureBuffer &features) {
+            getRemainingPluginFeaturesInto(m_plugin, features);
+        }
     protected:
         Impl *m_loader;
     };
@@ -111,6 +125,31 @@ protected:
     /// that were added to it
     vector<PluginKey> enumeratePlugins(Enumeration);
 
+    /**
+     * What enumeration found in one library file: the identifiers of
+     * its plugins, or that it had no descriptor function. Records are
+     * optionally cached on disk, keyed by library path and checked
+     * against the file's size and modification time, so that we need
+     * only load those libraries that have changed since we last looked.
+     */
+    struct LibraryRecord {
+        unsigned long long size;
+        long long modified;
+        bool hasDescriptorFunction;
+        vector<string> identifiers;
+        LibraryRecord() : size(0), modified(0), hasDescriptorFunction(false) { }
+    };
+    map<string, LibraryRecord> m_libraryCache;
+    bool m_libraryCacheEnabled;
+    bool m_libraryCacheLoaded;
+    bool m_libraryCacheChanged;
+
+    bool getLibraryRecord(string fullPath, LibraryRecord &record);
+    bool scanLibrary(string fullPath, LibraryRecord &record);
+    string getLibraryCachePath();
+    void loadLibraryCache();
+    void saveLibraryCache();
+
     map<PluginKey, PluginCategoryHierarchy> m_taxonomy;
     void generateTaxonomy();
 
@@ -174,7 +213,22 @@ PluginLoader::loadPlugin(PluginKey key,
                          float inputSampleRate,
                          int adapterFlags)
 {
-    return m_impl->loadPlugin(key, inputSampleRate, adapterFlags);
+    return m_impl->loadPlugin(key, inputSampleRate, adapterFlags, 0);
+}
+
+Plugin *
+PluginLoader::loadPlugin(PluginKey key,
+                         float inputSampleRate,
+                         int adapterFlags,
+                         SpectralSource *source)
+{
+    return m_impl->loadPlugin(key, inputSampleRate, adapterFlags, source);
+}
+
+void
+PluginLoader::setLibraryCacheEnabled(bool enabled)
+{
+    m_impl->setLibraryCacheEnabled(enabled);
 }
 
 PluginLoader::PluginKey
@@ -196,7 +250,10 @@ PluginLoader::getLibraryPathForPlugin(PluginKey key)
 }
  
 PluginLoader::Impl::Impl() :
-    m_allPluginsEnumerated(false)
+    m_allPluginsEnumerated(false),
+    m_libraryCacheEnabled(false),
+    m_libraryCacheLoaded(false),
+    m_libraryCacheChanged(false)
 {
 }
 
@@ -302,36 +359,28 @@ PluginLoader::Impl::enumeratePlugins(Enumeration enumeration)
     for (size_t i = 0; i < fullPaths.size(); ++i) {
 
         string fullPath = fullPaths[i];
-        void *handle = Files::loadLibrary(fullPath);
-        if (!handle) continue;
+        LibraryRecord record;
+        if (!getLibraryRecord(fullPath, record)) continue;
             
-        VampGetPluginDescriptorFunction fn =
-            (VampGetPluginDescriptorFunction)Files::lookupInLibrary
-            (handle, "vampGetPluginDescriptor");
-            
-        if (!fn) {
+        if (!record.hasDescriptorFunction) {
             if (specific) {
                 cerr << "Vamp::HostExt::PluginLoader: "
                     << "No vampGetPluginDescriptor function found in library \""
                      << fullPath << "\"" << endl;
             }
-            Files::unloadLibrary(handle);
             continue;
         }
             
-        int index = 0;
-        const VampPluginDescriptor *descriptor = 0;
         bool found = false;
             
-        while ((descriptor = fn(VAMP_API_VERSION, index))) {
-            ++index;
+        for (size_t j = 0; j < record.identifiers.size(); ++j) {
             if (identifier != "") {
-                if (descriptor->identifier != identifier) {
+                if (record.identifiers[j] != identifier) {
                     continue;
                 }
             }
             found = true;
-            PluginKey key = composePluginKey(fullPath, descriptor->identifier);
+            PluginKey key = composePluginKey(fullPath, record.identifiers[j]);
             if (m_pluginLibraryNameMap.find(key) ==
                 m_pluginLibraryNameMap.end()) {
                 m_pluginLibraryNameMap[key] = fullPath;
@@ -344,10 +393,27 @@ PluginLoader::Impl::enumeratePlugins(Enumeration enumeration)
                  << identifier << "\" not found in library \""
                  << fullPath << "\"" << endl;
         }
-            
-        Files::unloadLibrary(handle);
     }
 
+    if (enumeration.type == Enumeration::All) {
+        // Forget any libraries that no longer exist. Those that are
+        // merely not on our path are kept, as the cache file may be
+        // shared with processes that use a different path
+        map<string, LibraryRecord>::iterator ci = m_libraryCache.begin();
+        while (ci != m_libraryCache.end()) {
+            unsigned long long size = 0;
+            long long modified = 0;
+            if (!Files::getFileStamp(ci->first, size, modified)) {
+                m_libraryCache.erase(ci++);
+                m_libraryCacheChanged = true;
+            } else {
+                ++ci;
+            }
+        }
+    }
+
+    if (m_libraryCacheChanged) saveLibraryCache();
+    
     if (enumeration.type == Enumeration::All) {
         m_allPluginsEnumerated = true;
     }
@@ -355,6 +421,177 @@ PluginLoader::Impl::enumeratePlugins(Enumeration enumeration)
     return added;
 }
 
+bool
+PluginLoader::Impl::getLibraryRecord(string fullPath, LibraryRecord &record)
+{
+    if (!m_libraryCacheLoaded) loadLibraryCache();
+
+    unsigned long long size = 0;
+    long long modified = 0;
+    bool stamped = Files::getFileStamp(fullPath, size, modified);
+
+    if (stamped) {
+        map<string, LibraryRecord>::const_iterator ci =
+            m_libraryCache.find(fullPath);
+        if (ci != m_libraryCache.end() &&
+            ci->second.size == size &&
+            ci->second.modified == modified) {
+            record = ci->second;
+            return true;
+        }
+    }
+
+    if (!scanLibrary(fullPath, record)) {
+        // Not cached: it may be loadable by some other process
+        // (e.g. of a different architecture) sharing the cache
+        return false;
+    }
+
+    if (stamped) {
+        record.size = size;
+        record.modified = modified;
+        m_libraryCache[fullPath] = record;
+        m_libraryCacheChanged = true;
+    }
+    
+    return true;
+}
+
+bool
+PluginLoader::Impl::scanLibrary(string fullPath, LibraryRecord &record)
+{
+    void *handle = Files::loadLibrary(fullPath);
+    if (!handle) return false;
+            
+    VampGetPluginDescriptorFunction fn =
+        (VampGetPluginDescriptorFunction)Files::lookupInLibrary
+        (handle, "vampGetPluginDescriptor");
+
+    record.hasDescriptorFunction = (fn != 0);
+    record.identifiers.clear();
+    
+    if (fn) {
+        int index = 0;
+        const VampPluginDescriptor *descriptor = 0;
+        while ((descriptor = fn(VAMP_API_VERSION, index))) {
+            record.identifiers.push_back(descriptor->identifier);
+            ++index;
+        }
+    }
+    
+    Files::unloadLibrary(handle);
+    return true;
+}
+
+string
+PluginLoader::Impl::getLibraryCachePath()
+{
+    // VAMP_PLUGIN_CACHE overrides setLibraryCacheEnabled: set it to
+    // the empty string to disable the cache, or to a file path to
+    // enable it using that file instead of the default
+    
+    string path;
+    if (Files::getEnvUtf8("VAMP_PLUGIN_CACHE", path)) {
+        return path;
+    }
+
+    if (!m_libraryCacheEnabled) return "";
+
+    string dir = Files::getCacheDirectory();
+    if (dir == "") return "";
+
+    // Processes of different architectures may find different
+    // libraries loadable, so they get a cache each
+    ostringstream name;
+    name << "vamp-plugin-cache-" << (sizeof(void *) * 8) << ".txt";
+    return Files::splicePath(Files::splicePath(dir, "vamp"), name.str());
+}
+
+// Cache file layout: a header line, then for each library a line of
+// size, modification time, plugin count (or -1 if the library has no
+// descriptor function) and path, followed by one line per plugin
+// identifier; then an end marker, without which the file is ignored
+
+static const char *const libraryCacheHeader = "Vamp plugin library cache v1";
+static const char *const libraryCacheEnd = "end";
+
+void
+PluginLoader::Impl::loadLibraryCache()
+{
+    m_libraryCacheLoaded = true;
+
+    string path = getLibraryCachePath();
+    if (path == "") return;
+
+    ifstream is(path.c_str(), ifstream::in | ifstream::binary);
+    if (is.fail()) return;
+
+    map<string, LibraryRecord> cache;
+    string line;
+    
+    if (!getline(is, line) || line != libraryCacheHeader) return;
+
+    while (getline(is, line)) {
+
+        if (line == libraryCacheEnd) {
+            m_libraryCache = cache;
+            return;
+        }
+
+        istringstream ls(line);
+        LibraryRecord record;
+        int count = 0;
+        string fullPath;
+        if (!(ls >> record.size >> record.modified >> count) ||
+            ls.get() != ' ' || !getline(ls, fullPath) || fullPath == "") {
+            break;
+        }
+        
+        record.hasDescriptorFunction = (count >= 0);
+        for (int i = 0; i < count; ++i) {
+            if (!getline(is, line)) break;
+            record.identifiers.push_back(line);
+        }
+        if (int(record.identifiers.size()) < count) break;
+
+        cache[fullPath] = record;
+    }
+
+    // No end marker, so the file is incomplete or damaged: ignore it,
+    // and we will write a fresh one after enumerating
+}
+
+void
+PluginLoader::Impl::saveLibraryCache()
+{
+    m_libraryCacheChanged = false;
+
+    string path = getLibraryCachePath();
+    if (path == "") return;
+
+    ostringstream os;
+    os << libraryCacheHeader << "\n";
+    
+    for (map<string, LibraryRecord>::const_iterator ci =
+             m_libraryCache.begin(); ci != m_libraryCache.end(); ++ci) {
+        const LibraryRecord &record = ci->second;
+        int count = record.hasDescriptorFunction ?
+            int(record.identifiers.size()) : -1;
+        os << record.size << " " << record.modified << " " << count
+           << " " << ci->first << "\n";
+        for (size_t i = 0; i < record.identifiers.size(); ++i) {
+            os << record.identifiers[i] << "\n";
+        }
+    }
+
+    os << libraryCacheEnd << "\n";
+
+    // Failure is not an error: we just enumerate again next time.
+    // The directory will not exist yet on the first run
+    if (!Files::makeParentDirectory(path)) return;
+    (void)Files::replaceFile(path, os.str());
+}
+
 PluginLoader::PluginKey
 PluginLoader::Impl::composePluginKey(string libraryName, string identifier)
 {
@@ -403,9 +640,19 @@ PluginLoader::Impl::getLibraryPathForPlugin(PluginKey plugin)
     return m_pluginLibraryNameMap[plugin];
 }    
 
+void
+PluginLoader::Impl::setLibraryCacheEnabled(bool enabled)
+{
+    if (enabled == m_libraryCacheEnabled) return;
+    m_libraryCacheEnabled = enabled;
+    // Read the file afresh on next use, in case it is now in effect
+    m_libraryCacheLoaded = false;
+}
+
 Plugin *
 PluginLoader::Impl::loadPlugin(PluginKey key,
-                               float inputSampleRate, int adapterFlags)
+                               float inputSampleRate, int adapterFlags,
+                               SpectralSource *source)
 {
     string libname, identifier;
     if (!decomposePluginKey(key, libname, identifier)) {
@@ -450,7 +697,10 @@ PluginLoader::Impl::loadPlugin(PluginKey key,
 
             if (adapterFlags & ADAPT_INPUT_DOMAIN) {
                 if (adapter->getInputDomain() == Plugin::FrequencyDomain) {
-                    adapter = new PluginInputDomainAdapter(adapter);
+                    PluginInputDomainAdapter *ida =
+                        new PluginInputDomainAdapter(adapter);
+                    if (source) ida->setSpectralSource(source);
+                    adapter = ida;
                 }
             }
 
@@ -65,6 +65,10 @@ public:
     FeatureSet process(const float *const *inputBuffers, RealTime timestamp);
     FeatureSet getRemainingFeatures();
 
+    void processInto(const float *const *inputBuffers, RealTime timestamp,
+                     FeatureBuffer &features);
+    void getRemainingFeaturesInto(FeatureBuffer &features);
+
     void setSummarySegmentBoundaries(const SegmentBoundaries &);
 
     FeatureList getSummaryForOutput(int output,
@@ -140,6 +144,7 @@ protected:
     RealTime m_endTime;
 
     void accumulate(const FeatureSet &fs, RealTime, bool final);
+    void accumulate(const FeatureBuffer &fb, RealTime, bool final);
     void accumulate(int output, const Feature &f, RealTime, bool final);
     void accumulateFinalDurations();
     void findSegmentBounds(RealTime t, RealTime &start, RealTime &end);
@@ -189,6 +194,20 @@ PluginSummarisingAdapter::getRemainingFeatures()
     return m_impl->getRemainingFeatures();
 }
 
+void
+PluginSummarisingAdapter::processInto(const float *const *inputBuffers,
+                                      RealTime timestamp,
+                                      FeatureBuffer &features)
+{
+    m_impl->processInto(inputBuffers, timestamp, features);
+}
+
+void
+PluginSummarisingAdapter::getRemainingFeaturesInto(FeatureBuffer &features)
+{
+    m_impl->getRemainingFeaturesInto(features);
+}
+
 void
 PluginSummarisingAdapter::setSummarySegmentBoundaries(const SegmentBoundaries &b)
 {
@@ -271,6 +290,30 @@ PluginSummarisingAdapter::Impl::getRemainingFeatures()
     return fs;
 }
 
+void
+PluginSummarisingAdapter::Impl::processInto(const float *const *inputBuffers,
+                                            RealTime timestamp,
+                                            FeatureBuffer &features)
+{
+    if (m_reduced) {
+        cerr << "WARNING: Cannot call PluginSummarisingAdapter::process() or getRemainingFeatures() after one of the getSummary methods" << endl;
+    }
+    processPluginInto(m_plugin, inputBuffers, timestamp, features);
+    accumulate(features, timestamp, false);
+    m_endTime = timestamp + 
+        RealTime::frame2RealTime(m_stepSize, int(m_inputSampleRate + 0.5));
+}
+
+void
+PluginSummarisingAdapter::Impl::getRemainingFeaturesInto(FeatureBuffer &features)
+{
+    if (m_reduced) {
+        cerr << "WARNING: Cannot call PluginSummarisingAdapter::process() or getRemainingFeatures() after one of the getSummary methods" << endl;
+    }
+    getRemainingPluginFeaturesInto(m_plugin, features);
+    accumulate(features, m_endTime, true);
+}
+
 void
 PluginSummarisingAdapter::Impl::setSummarySegmentBoundaries(const SegmentBoundaries &b)
 {
@@ -452,6 +495,24 @@ PluginSummarisingAdapter::Impl::getSummaryLabel(SummaryType type,
     return label;
 }
 
+void
+PluginSummarisingAdapter::Impl::accumulate(const FeatureBuffer &fb,
+                                           RealTime timestamp, 
+                                           bool final)
+{
+    for (int output = 0; output < fb.getOutputCount(); ++output) {
+        size_t count = fb.getFeatureCount(output);
+        for (size_t j = 0; j < count; ++j) {
+            const Feature &f = fb.getFeature(output, j);
+            if (f.hasTimestamp) {
+                accumulate(output, f, f.timestamp, final);
+            } else {
+                accumulate(output, f, timestamp, final);
+            }
+        }
+    }
+}
+
 void
 PluginSummarisingAdapter::Impl::accumulate(int output,
                                            const Feature &f,
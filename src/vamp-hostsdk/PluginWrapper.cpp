@@ -35,6 +35,14 @@
 */
 
 #include <vamp-hostsdk/PluginWrapper.h>
+#include <vamp-hostsdk/PluginHostAdapter.h>
+#include <vamp-hostsdk/PluginInputDomainAdapter.h>
+#include <vamp-hostsdk/PluginChannelAdapter.h>
+#include <vamp-hostsdk/PluginBufferingAdapter.h>
+#include <vamp-hostsdk/PluginSummarisingAdapter.h>
+
+#include <iostream>
+#include <typeinfo>
 
 _VAMP_SDK_HOSTSPACE_BEGIN(PluginWrapper.cpp)
 
@@ -42,6 +50,163 @@ namespace Vamp {
 
 namespace HostExt {
 
+FeatureBuffer::FeatureBuffer()
+{
+}
+
+FeatureBuffer::~FeatureBuffer()
+{
+}
+
+void
+FeatureBuffer::clear()
+{
+    m_counts.assign(m_counts.size(), 0);
+}
+
+void
+FeatureBuffer::reserve(int output, size_t features, size_t values)
+{
+    if (output < 0) return;
+    if (size_t(output) >= m_lists.size()) {
+        m_lists.resize(output + 1);
+        m_counts.resize(output + 1, 0);
+    }
+    Plugin::FeatureList &list = m_lists[output];
+    if (list.size() < features) {
+        list.resize(features);
+    }
+    for (size_t i = 0; i < list.size(); ++i) {
+        list[i].values.reserve(values);
+    }
+}
+
+bool
+FeatureBuffer::empty() const
+{
+    for (size_t i = 0; i < m_counts.size(); ++i) {
+        if (m_counts[i] > 0) return false;
+    }
+    return true;
+}
+
+int
+FeatureBuffer::getOutputCount() const
+{
+    return int(m_counts.size());
+}
+
+size_t
+FeatureBuffer::getFeatureCount(int output) const
+{
+    if (output < 0 || size_t(output) >= m_counts.size()) return 0;
+    return m_counts[output];
+}
+
+Plugin::Feature &
+FeatureBuffer::addFeature(int output)
+{
+    if (output < 0) {
+        std::cerr << "ERROR: FeatureBuffer::addFeature: Negative output "
+                  << "number " << output << std::endl;
+        m_scratch = Plugin::Feature();
+        return m_scratch;
+    }
+
+    if (size_t(output) >= m_lists.size()) {
+        m_lists.resize(output + 1);
+        m_counts.resize(output + 1, 0);
+    }
+
+    Plugin::FeatureList &list = m_lists[output];
+    size_t &count = m_counts[output];
+
+    if (count == list.size()) {
+        list.push_back(Plugin::Feature());
+        return list[count++];
+    }
+
+    Plugin::Feature &feature = list[count++];
+    feature.hasTimestamp = false;
+    feature.timestamp = RealTime::zeroTime;
+    feature.hasDuration = false;
+    feature.duration = RealTime::zeroTime;
+    feature.values.clear();
+    feature.label.clear();
+    return feature;
+}
+
+Plugin::Feature &
+FeatureBuffer::addFeature(int output, const Plugin::Feature &feature)
+{
+    if (output < 0) {
+        std::cerr << "ERROR: FeatureBuffer::addFeature: Negative output "
+                  << "number " << output << std::endl;
+        m_scratch = feature;
+        return m_scratch;
+    }
+
+    if (size_t(output) >= m_lists.size()) {
+        m_lists.resize(output + 1);
+        m_counts.resize(output + 1, 0);
+    }
+
+    Plugin::FeatureList &list = m_lists[output];
+    size_t &count = m_counts[output];
+
+    if (count == list.size()) {
+        list.push_back(feature);
+    } else {
+        // Assignment reuses the existing values and label storage
+        list[count] = feature;
+    }
+    return list[count++];
+}
+
+void
+FeatureBuffer::addFeatures(const Plugin::FeatureSet &features)
+{
+    for (Plugin::FeatureSet::const_iterator i = features.begin();
+         i != features.end(); ++i) {
+        if (i->first < 0) continue;
+        const Plugin::FeatureList &list = i->second;
+        for (size_t j = 0; j < list.size(); ++j) {
+            addFeature(i->first, list[j]);
+        }
+    }
+}
+
+void
+FeatureBuffer::addFeatures(const FeatureBuffer &features)
+{
+    for (int output = 0; output < features.getOutputCount(); ++output) {
+        size_t count = features.getFeatureCount(output);
+        for (size_t j = 0; j < count; ++j) {
+            addFeature(output, features.getFeature(output, j));
+        }
+    }
+}
+
+void
+FeatureBuffer::addTo(Plugin::FeatureSet &features) const
+{
+    for (size_t output = 0; output < m_counts.size(); ++output) {
+        size_t count = m_counts[output];
+        if (count == 0) continue;
+        const Plugin::FeatureList &list = m_lists[output];
+        Plugin::FeatureList &target = features[int(output)];
+        target.insert(target.end(), list.begin(), list.begin() + count);
+    }
+}
+
+Plugin::FeatureSet
+FeatureBuffer::toFeatureSet() const
+{
+    Plugin::FeatureSet features;
+    addTo(features);
+    return features;
+}
+
 PluginWrapper::PluginWrapper(Plugin *plugin) :
     Plugin(plugin->getInputSampleRate()),
     m_plugin(plugin),
@@ -199,6 +364,119 @@ PluginWrapper::getRemainingFeatures()
     return m_plugin->getRemainingFeatures();
 }
 
+bool
+PluginWrapper::pluginSupportsStridedInput(const Plugin *plugin)
+{
+    // Only the exact adapter types are known to read strided input
+    // correctly: a subclass might override process() in a way that
+    // processStrided() would bypass
+
+    const std::type_info &type = typeid(*plugin);
+    if (type == typeid(PluginInputDomainAdapter)) {
+        return static_cast<const PluginInputDomainAdapter *>(plugin)->
+            supportsStridedInput();
+    }
+    if (type == typeid(PluginChannelAdapter)) {
+        return static_cast<const PluginChannelAdapter *>(plugin)->
+            supportsStridedInput();
+    }
+    const StridedInputProcessor *sp =
+        dynamic_cast<const StridedInputProcessor *>(plugin);
+    return sp && sp->supportsStridedInput();
+}
+
+Plugin::FeatureSet
+PluginWrapper::processPluginStrided(Plugin *plugin,
+                                    const float *const *inputBuffers,
+                                    size_t stride,
+                                    RealTime timestamp)
+{
+    if (stride == 1) {
+        return plugin->process(inputBuffers, timestamp);
+    }
+
+    const std::type_info &type = typeid(*plugin);
+    if (type == typeid(PluginInputDomainAdapter)) {
+        return static_cast<PluginInputDomainAdapter *>(plugin)->
+            processStrided(inputBuffers, stride, timestamp);
+    }
+    if (type == typeid(PluginChannelAdapter)) {
+        return static_cast<PluginChannelAdapter *>(plugin)->
+            processStrided(inputBuffers, stride, timestamp);
+    }
+    StridedInputProcessor *sp = dynamic_cast<StridedInputProcessor *>(plugin);
+    if (sp && sp->supportsStridedInput()) {
+        return sp->processStrided(inputBuffers, stride, timestamp);
+    }
+
+    std::cerr << "ERROR: PluginWrapper::processPluginStrided: Strided input "
+              << "is not supported by this plugin" << std::endl;
+    return FeatureSet();
+}
+
+void
+PluginWrapper::processPluginInto(Plugin *plugin,
+                                 const float *const *inputBuffers,
+                                 RealTime timestamp,
+                                 FeatureBuffer &features)
+{
+    // As with strided input, only the exact adapter types are known
+    // to return the same features here as they would from process()
+
+    const std::type_info &type = typeid(*plugin);
+    if (type == typeid(PluginInputDomainAdapter)) {
+        static_cast<PluginInputDomainAdapter *>(plugin)->
+            processInto(inputBuffers, timestamp, features);
+    } else if (type == typeid(PluginChannelAdapter)) {
+        static_cast<PluginChannelAdapter *>(plugin)->
+            processInto(inputBuffers, timestamp, features);
+    } else if (type == typeid(PluginBufferingAdapter)) {
+        static_cast<PluginBufferingAdapter *>(plugin)->
+            processInto(inputBuffers, timestamp, features);
+    } else if (type == typeid(PluginSummarisingAdapter)) {
+        static_cast<PluginSummarisingAdapter *>(plugin)->
+            processInto(inputBuffers, timestamp, features);
+    } else if (type == typeid(PluginHostAdapter)) {
+        static_cast<PluginHostAdapter *>(plugin)->
+            processInto(inputBuffers, timestamp, features);
+    } else if (FeatureBufferProcessor *fp =
+               dynamic_cast<FeatureBufferProcessor *>(plugin)) {
+        fp->processInto(inputBuffers, timestamp, features);
+    } else {
+        features.clear();
+        features.addFeatures(plugin->process(inputBuffers, timestamp));
+    }
+}
+
+void
+PluginWrapper::getRemainingPluginFeaturesInto(Plugin *plugin,
+                                              FeatureBuffer &features)
+{
+    const std::type_info &type = typeid(*plugin);
+    if (type == typeid(PluginInputDomainAdapter)) {
+        static_cast<PluginInputDomainAdapter *>(plugin)->
+            getRemainingFeaturesInto(features);
+    } else if (type == typeid(PluginChannelAdapter)) {
+        static_cast<PluginChannelAdapter *>(plugin)->
+            getRemainingFeaturesInto(features);
+    } else if (type == typeid(PluginBufferingAdapter)) {
+        static_cast<PluginBufferingAdapter *>(plugin)->
+            getRemainingFeaturesInto(features);
+    } else if (type == typeid(PluginSummarisingAdapter)) {
+        static_cast<PluginSummarisingAdapter *>(plugin)->
+            getRemainingFeaturesInto(features);
+    } else if (type == typeid(PluginHostAdapter)) {
+        static_cast<PluginHostAdapter *>(plugin)->
+            getRemainingFeaturesInto(features);
+    } else if (FeatureBufferProcessor *fp =
+               dynamic_cast<FeatureBufferProcessor *>(plugin)) {
+        fp->getRemainingFeaturesInto(features);
+    } else {
+        features.clear();
+        features.addFeatures(plugin->getRemainingFeatures());
+    }
+}
+
 }
 
 }
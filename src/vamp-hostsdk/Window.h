@@ -41,6 +41,10 @@
 
 #include <cmath>
 #include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
 
 _VAMP_SDK_HOSTSPACE_BEGIN(Window.h)
 
@@ -59,18 +63,24 @@ public:
     };
 
     /**
-     * Construct a windower of the given type.
+     * Construct a windower of the given type. The coefficients are
+     * shared with any other windower of the same type, size and
+     * sample type that exists at the same time.
      */
     Window(WindowType type, size_t size) : m_type(type), m_size(size) { encache(); }
-    Window(const Window &w) : m_type(w.m_type), m_size(w.m_size) { encache(); }
+    Window(const Window &w) :
+        m_type(w.m_type), m_size(w.m_size), m_table(w.m_table),
+        m_cache(w.m_cache), m_area(w.m_area) { }
     Window &operator=(const Window &w) {
 	if (&w == this) return *this;
 	m_type = w.m_type;
 	m_size = w.m_size;
-	encache();
+	m_table = w.m_table;
+	m_cache = w.m_cache;
+	m_area = w.m_area;
 	return *this;
     }
-    virtual ~Window() { delete[] m_cache; }
+    virtual ~Window() { }
     
     void cut(T *src) const { cut(src, src); }
     void cut(T *src, T *dst) const {
@@ -81,6 +91,50 @@ public:
 	for (size_t i = 0; i < m_size; ++i) dst[i] = src[i] * m_cache[i];
     }
 
+    /**
+     * Window src into dst and rotate the result by half the window
+     * size (an fftshift, for an even size) in the same pass, so that
+     * the first half of the windowed frame ends up in the second half
+     * of dst and vice versa. src and dst must not overlap.
+     */
+    void cutShifted(const T *src, T *dst) const {
+        cutShifted(src, src + m_size / 2, dst);
+    }
+
+    /**
+     * As cutShifted(src, dst), but with the frame supplied in two
+     * separate parts: its first m_size/2 samples at firstHalf and the
+     * rest at secondHalf.
+     */
+    void cutShifted(const T *firstHalf, const T *secondHalf, T *dst) const {
+        const size_t h = m_size / 2, r = m_size - h;
+        for (size_t i = 0; i < r; ++i) dst[i] = secondHalf[i] * m_cache[i + h];
+        for (size_t i = 0; i < h; ++i) dst[i + r] = firstHalf[i] * m_cache[i];
+    }
+
+    /**
+     * As cutShifted(src, dst), but reading every stride'th sample of
+     * src, for input that is not contiguous (such as one channel of
+     * an interleaved buffer).
+     */
+    void cutShifted(const T *src, size_t stride, T *dst) const {
+        const size_t h = m_size / 2, r = m_size - h;
+        const T *secondHalf = src + h * stride;
+        for (size_t i = 0; i < r; ++i) dst[i] = secondHalf[i * stride] * m_cache[i + h];
+        for (size_t i = 0; i < h; ++i) dst[i + r] = src[i * stride] * m_cache[i];
+    }
+
+    /**
+     * As cutShifted(firstHalf, secondHalf, dst), but reading every
+     * stride'th sample of secondHalf. The first half is contiguous.
+     */
+    void cutShifted(const T *firstHalf, const T *secondHalf, size_t stride,
+                    T *dst) const {
+        const size_t h = m_size / 2, r = m_size - h;
+        for (size_t i = 0; i < r; ++i) dst[i] = secondHalf[i * stride] * m_cache[i + h];
+        for (size_t i = 0; i < h; ++i) dst[i + r] = firstHalf[i] * m_cache[i];
+    }
+
     T getArea() { return m_area; }
     T getValue(size_t i) { return m_cache[i]; }
 
@@ -88,24 +142,96 @@ public:
     size_t getSize() const { return m_size; }
 
 protected:
+    /**
+     * The immutable coefficients for one type and size of window.
+     */
+    struct Table {
+        Table(size_t n) : coefficients(new T[n]), area(0) { }
+        ~Table() { delete[] coefficients; }
+        T *coefficients;
+        T area;
+    private:
+        Table(const Table &);
+        Table &operator=(const Table &);
+    };
+    
     WindowType m_type;
     size_t m_size;
-    T *m_cache;
+    std::shared_ptr<const Table> m_table;
+    const T *m_cache;
     T m_area;
     
     void encache();
-    void cosinewin(T *, T, T, T, T);
+    static std::shared_ptr<const Table> getTable(WindowType type, size_t size);
+    static void calculate(WindowType type, size_t size, T *mult);
+    static void cosinewin(T *, size_t, T, T, T, T);
 };
 
 template <typename T>
 void Window<T>::encache()
 {
-    int n = int(m_size);
-    T *mult = new T[n];
+    m_table = getTable(m_type, m_size);
+    m_cache = m_table->coefficients;
+    m_area = m_table->area;
+}
+
+template <typename T>
+std::shared_ptr<const typename Window<T>::Table>
+Window<T>::getTable(WindowType type, size_t size)
+{
+    // A process-wide cache of the tables currently in use, so that
+    // hosts creating many adapters with the same window calculate
+    // and store its coefficients only once. The cache holds weak
+    // references, so a table is freed when its last windower is
+    // destroyed. The mutex and map are deliberately never destroyed,
+    // so that windowers may safely outlive them at static
+    // destruction time
+    
+    typedef std::pair<int, size_t> Key;
+    typedef std::map<Key, std::weak_ptr<const Table> > Cache;
+
+    static std::mutex &mutex = *new std::mutex;
+    static Cache &cache = *new Cache;
+
+    std::lock_guard<std::mutex> guard(mutex);
+
+    Key key(int(type), size);
+    typename Cache::iterator i = cache.find(key);
+    if (i != cache.end()) {
+        std::shared_ptr<const Table> table = i->second.lock();
+        if (table) return table;
+    }
+
+    // About to add an entry: take the opportunity to drop any whose
+    // tables have gone, so that the cache stays small however many
+    // sizes are used over the life of the process
+    for (i = cache.begin(); i != cache.end(); ) {
+        if (i->second.expired()) cache.erase(i++);
+        else ++i;
+    }
+    
+    Table *table = new Table(size);
+    calculate(type, size, table->coefficients);
+
+    int n = int(size);
+    for (int j = 0; j < n; ++j) {
+        table->area += table->coefficients[j];
+    }
+    table->area /= n;
+
+    std::shared_ptr<const Table> shared(table);
+    cache[key] = shared;
+    return shared;
+}
+
+template <typename T>
+void Window<T>::calculate(WindowType type, size_t size, T *mult)
+{
+    int n = int(size);
     int i;
     for (i = 0; i < n; ++i) mult[i] = 1.0;
 
-    switch (m_type) {
+    switch (type) {
 		
     case RectangularWindow:
 	for (i = 0; i < n; ++i) {
@@ -121,39 +247,31 @@ void Window<T>::encache()
 	break;
 	    
     case HammingWindow:
-        cosinewin(mult, 0.54, 0.46, 0.0, 0.0);
+        cosinewin(mult, size, 0.54, 0.46, 0.0, 0.0);
 	break;
 	    
     case HanningWindow:
-        cosinewin(mult, 0.50, 0.50, 0.0, 0.0);
+        cosinewin(mult, size, 0.50, 0.50, 0.0, 0.0);
 	break;
 	    
     case BlackmanWindow:
-        cosinewin(mult, 0.42, 0.50, 0.08, 0.0);
+        cosinewin(mult, size, 0.42, 0.50, 0.08, 0.0);
 	break;
 
     case NuttallWindow:
-        cosinewin(mult, 0.3635819, 0.4891775, 0.1365995, 0.0106411);
+        cosinewin(mult, size, 0.3635819, 0.4891775, 0.1365995, 0.0106411);
 	break;
 
     case BlackmanHarrisWindow:
-        cosinewin(mult, 0.35875, 0.48829, 0.14128, 0.01168);
+        cosinewin(mult, size, 0.35875, 0.48829, 0.14128, 0.01168);
         break;
     }
-	
-    m_cache = mult;
-
-    m_area = 0;
-    for (int i = 0; i < n; ++i) {
-        m_area += m_cache[i];
-    }
-    m_area /= n;
 }
 
 template <typename T>
-void Window<T>::cosinewin(T *mult, T a0, T a1, T a2, T a3)
+void Window<T>::cosinewin(T *mult, size_t size, T a0, T a1, T a2, T a3)
 {
-    int n = int(m_size);
+    int n = int(size);
     for (int i = 0; i < n; ++i) {
         mult[i] *= (a0
                     - a1 * cos((2 * M_PI * i) / n)
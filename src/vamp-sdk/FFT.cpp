@@ -41,6 +41,11 @@
 #include <math.h>
 #include <string.h>
 
+#include <mutex>
+#include <vector>
+
+#include "FFTsimd.h"
+
 #if ( VAMP_SDK_MAJOR_VERSION != 2 || VAMP_SDK_MINOR_VERSION != 10 )
 #error Unexpected version of Vamp SDK header included
 #endif
@@ -53,15 +58,104 @@ namespace Vamp {
 
 using namespace Kiss;
 
+/**
+ * Process-wide cache of plans and scratch buffers for the one-shot
+ * FFT::forward and FFT::inverse calls, keyed by size and direction.
+ *
+ * A plan is checked out for the duration of a single transform, so
+ * concurrent callers never share scratch space: if every cached plan
+ * of the right shape is already in use, another one is made. At most
+ * m_maxIdle plans are retained between calls, the least recently used
+ * being discarded first, so memory use stays bounded however many
+ * different sizes are requested.
+ */
+class FFTPlanCache
+{
+public:
+    struct Plan {
+        Plan(int n_, bool inverse_) :
+            n(n_),
+            inverse(inverse_),
+            cfg(vamp_kiss_fft_alloc(n, inverse, 0, 0)),
+            in(new vamp_kiss_fft_cpx[n]),
+            out(new vamp_kiss_fft_cpx[n]) { }
+        ~Plan() {
+            vamp_kiss_fft_free(cfg);
+            delete[] in;
+            delete[] out;
+        }
+        int n;
+        bool inverse;
+        vamp_kiss_fft_cfg cfg;
+        vamp_kiss_fft_cpx *in;
+        vamp_kiss_fft_cpx *out;
+    private:
+        Plan(const Plan &); // not provided
+        Plan &operator=(const Plan &); // not provided
+    };
+
+    static Plan *acquire(int n, bool inverse) {
+        FFTPlanCache &cache = instance();
+        {
+            std::lock_guard<std::mutex> guard(cache.m_mutex);
+            // most recently released plans are at the back
+            for (size_t i = cache.m_idle.size(); i > 0; ) {
+                --i;
+                Plan *plan = cache.m_idle[i];
+                if (plan->n == n && plan->inverse == inverse) {
+                    cache.m_idle.erase(cache.m_idle.begin() + i);
+                    return plan;
+                }
+            }
+        }
+        return new Plan(n, inverse);
+    }
+
+    static void release(Plan *plan) {
+        FFTPlanCache &cache = instance();
+        Plan *discard = 0;
+        {
+            std::lock_guard<std::mutex> guard(cache.m_mutex);
+            if (cache.m_idle.size() == m_maxIdle) {
+                discard = cache.m_idle[0];
+                cache.m_idle.erase(cache.m_idle.begin());
+            }
+            cache.m_idle.push_back(plan);
+        }
+        delete discard;
+    }
+
+private:
+    FFTPlanCache() {
+        m_idle.reserve(m_maxIdle);
+    }
+
+    ~FFTPlanCache() {
+        for (size_t i = 0; i < m_idle.size(); ++i) {
+            delete m_idle[i];
+        }
+    }
+
+    static FFTPlanCache &instance() {
+        static FFTPlanCache cache;
+        return cache;
+    }
+
+    static const size_t m_maxIdle = 16;
+
+    std::mutex m_mutex;
+    std::vector<Plan *> m_idle;
+};
+
 void
 FFT::forward(unsigned int un,
 	     const double *ri, const double *ii,
 	     double *ro, double *io)
 {
     int n(un);
-    vamp_kiss_fft_cfg c = vamp_kiss_fft_alloc(n, false, 0, 0);
-    vamp_kiss_fft_cpx *in = new vamp_kiss_fft_cpx[n];
-    vamp_kiss_fft_cpx *out = new vamp_kiss_fft_cpx[n];
+    FFTPlanCache::Plan *plan = FFTPlanCache::acquire(n, false);
+    vamp_kiss_fft_cpx *in = plan->in;
+    vamp_kiss_fft_cpx *out = plan->out;
     for (int i = 0; i < n; ++i) {
         in[i].r = ri[i];
         in[i].i = 0;
@@ -71,14 +165,12 @@ FFT::forward(unsigned int un,
             in[i].i = ii[i];
         }
     }
-    vamp_kiss_fft(c, in, out);
+    vamp_kiss_fft(plan->cfg, in, out);
     for (int i = 0; i < n; ++i) {
         ro[i] = out[i].r;
         io[i] = out[i].i;
     }
-    vamp_kiss_fft_free(c);
-    delete[] in;
-    delete[] out;
+    FFTPlanCache::release(plan);
 }
 
 void
@@ -87,9 +179,9 @@ FFT::inverse(unsigned int un,
 	     double *ro, double *io)
 {
     int n(un);
-    vamp_kiss_fft_cfg c = vamp_kiss_fft_alloc(n, true, 0, 0);
-    vamp_kiss_fft_cpx *in = new vamp_kiss_fft_cpx[n];
-    vamp_kiss_fft_cpx *out = new vamp_kiss_fft_cpx[n];
+    FFTPlanCache::Plan *plan = FFTPlanCache::acquire(n, true);
+    vamp_kiss_fft_cpx *in = plan->in;
+    vamp_kiss_fft_cpx *out = plan->out;
     for (int i = 0; i < n; ++i) {
         in[i].r = ri[i];
         in[i].i = 0;
@@ -99,15 +191,13 @@ FFT::inverse(unsigned int un,
             in[i].i = ii[i];
         }
     }
-    vamp_kiss_fft(c, in, out);
+    vamp_kiss_fft(plan->cfg, in, out);
     double scale = 1.0 / double(n);
     for (int i = 0; i < n; ++i) {
         ro[i] = out[i].r * scale;
         io[i] = out[i].i * scale;
     }
-    vamp_kiss_fft_free(c);
-    delete[] in;
-    delete[] out;
+    FFTPlanCache::release(plan);
 }
 
 class FFTComplex::D
@@ -201,29 +291,51 @@ public:
         delete[] m_freq;
     }
 
-    void forward(const double *ri, double *co) {
-        for (int i = 0; i < m_n; ++i) {
-            // in case vamp_kiss_fft_scalar is float
-            m_ri[i] = ri[i];
-        }
-        vamp_kiss_fftr(m_fconf, m_ri, m_freq);
-        int hs = m_n/2 + 1;
-        for (int i = 0; i < hs; ++i) {
-            co[i*2] = m_freq[i].r;
-            co[i*2+1] = m_freq[i].i;
+    void forward(const double *ri, size_t inStride,
+                 double *co, size_t outStride, int count) {
+        for (int f = 0; f < count; ++f) {
+            const double *in = ri + f * inStride;
+            double *out = co + f * outStride;
+#ifdef SINGLE_PRECISION_FFT
+            for (int i = 0; i < m_n; ++i) {
+                m_ri[i] = in[i];
+            }
+            vamp_kiss_fftr(m_fconf, m_ri, m_freq);
+            int hs = m_n/2 + 1;
+            for (int i = 0; i < hs; ++i) {
+                out[i*2] = m_freq[i].r;
+                out[i*2+1] = m_freq[i].i;
+            }
+#else
+            // vamp_kiss_fft_cpx has the same layout as an interleaved
+            // double array, so no copying is needed
+            vamp_kiss_fftr(m_fconf, in, (vamp_kiss_fft_cpx *)out);
+#endif
         }
     }
 
-    void inverse(const double *ci, double *ro) {
-        int hs = m_n/2 + 1;
-        for (int i = 0; i < hs; ++i) {
-            m_freq[i].r = ci[i*2];
-            m_freq[i].i = ci[i*2+1];
-        }
-        vamp_kiss_fftri(m_iconf, m_freq, m_ro);
+    void inverse(const double *ci, size_t inStride,
+                 double *ro, size_t outStride, int count) {
         double scale = 1.0 / double(m_n);
-        for (int i = 0; i < m_n; ++i) {
-            ro[i] = m_ro[i] * scale;
+        for (int f = 0; f < count; ++f) {
+            const double *in = ci + f * inStride;
+            double *out = ro + f * outStride;
+#ifdef SINGLE_PRECISION_FFT
+            int hs = m_n/2 + 1;
+            for (int i = 0; i < hs; ++i) {
+                m_freq[i].r = in[i*2];
+                m_freq[i].i = in[i*2+1];
+            }
+            vamp_kiss_fftri(m_iconf, m_freq, m_ro);
+            for (int i = 0; i < m_n; ++i) {
+                out[i] = m_ro[i] * scale;
+            }
+#else
+            vamp_kiss_fftri(m_iconf, (const vamp_kiss_fft_cpx *)in, out);
+            for (int i = 0; i < m_n; ++i) {
+                out[i] *= scale;
+            }
+#endif
         }
     }
     
@@ -249,13 +361,186 @@ FFTReal::~FFTReal()
 void
 FFTReal::forward(const double *ri, double *co)
 {
-    m_d->forward(ri, co);
+    m_d->forward(ri, 0, co, 0, 1);
 }
 
 void
 FFTReal::inverse(const double *ci, double *ro)
 {
-    m_d->inverse(ci, ro);
+    m_d->inverse(ci, 0, ro, 0, 1);
+}
+
+void
+FFTReal::forwardBatch(const double *ri, unsigned int inStride,
+                      double *co, unsigned int outStride,
+                      unsigned int count)
+{
+    m_d->forward(ri, inStride, co, outStride, count);
+}
+
+void
+FFTReal::inverseBatch(const double *ci, unsigned int inStride,
+                      double *ro, unsigned int outStride,
+                      unsigned int count)
+{
+    m_d->inverse(ci, inStride, ro, outStride, count);
+}
+
+// The single-precision classes use the float KissFFT instantiation,
+// whose complex type has the same layout as an interleaved float
+// array, so they can mostly transform straight between the caller's
+// buffers without any conversion
+
+class FFTComplexFloat::D
+{
+public:
+    D(int n) :
+        m_n(n),
+        m_fconf(KissFloat::vamp_kiss_fft_alloc(n, false, 0, 0)),
+        m_iconf(KissFloat::vamp_kiss_fft_alloc(n, true, 0, 0)),
+        m_co(new KissFloat::vamp_kiss_fft_cpx[m_n]) { }
+
+    ~D() {
+        KissFloat::vamp_kiss_fft_free(m_fconf);
+        KissFloat::vamp_kiss_fft_free(m_iconf);
+        delete[] m_co;
+    }
+
+    void forward(const float *ci, float *co) {
+        transform(m_fconf, ci, co);
+    }
+
+    void inverse(const float *ci, float *co) {
+        transform(m_iconf, ci, co);
+        float scale = 1.f / float(m_n);
+        for (int i = 0; i < m_n * 2; ++i) {
+            co[i] *= scale;
+        }
+    }
+    
+private:
+    int m_n;
+    KissFloat::vamp_kiss_fft_cfg m_fconf;
+    KissFloat::vamp_kiss_fft_cfg m_iconf;
+    KissFloat::vamp_kiss_fft_cpx *m_co;
+
+    void transform(KissFloat::vamp_kiss_fft_cfg conf,
+                   const float *ci, float *co) {
+        const KissFloat::vamp_kiss_fft_cpx *in =
+            (const KissFloat::vamp_kiss_fft_cpx *)ci;
+        if (ci == co) {
+            // KissFFT would allocate a temporary buffer for in-place
+            // use, so use our own instead
+            KissFloat::vamp_kiss_fft(conf, in, m_co);
+            memcpy(co, m_co, m_n * sizeof(KissFloat::vamp_kiss_fft_cpx));
+        } else {
+            KissFloat::vamp_kiss_fft(conf, in,
+                                     (KissFloat::vamp_kiss_fft_cpx *)co);
+        }
+    }
+};
+
+FFTComplexFloat::FFTComplexFloat(unsigned int n) :
+    m_d(new D(n))
+{
+}
+
+FFTComplexFloat::~FFTComplexFloat()
+{
+    delete m_d;
+}
+
+void
+FFTComplexFloat::forward(const float *ci, float *co)
+{
+    m_d->forward(ci, co);
+}
+
+void
+FFTComplexFloat::inverse(const float *ci, float *co)
+{
+    m_d->inverse(ci, co);
+}
+
+class FFTRealFloat::D
+{
+public:
+    D(int n) :
+        m_n(n),
+        m_fconf(KissFloat::vamp_kiss_fftr_alloc(n, false, 0, 0)),
+        m_iconf(KissFloat::vamp_kiss_fftr_alloc(n, true, 0, 0)) { }
+
+    ~D() {
+        KissFloat::vamp_kiss_fftr_free(m_fconf);
+        KissFloat::vamp_kiss_fftr_free(m_iconf);
+    }
+
+    void forward(const float *ri, size_t inStride,
+                 float *co, size_t outStride, int count) {
+        for (int f = 0; f < count; ++f) {
+            KissFloat::vamp_kiss_fftr
+                (m_fconf, ri + f * inStride,
+                 (KissFloat::vamp_kiss_fft_cpx *)(co + f * outStride));
+        }
+    }
+
+    void inverse(const float *ci, size_t inStride,
+                 float *ro, size_t outStride, int count) {
+        float scale = 1.f / float(m_n);
+        for (int f = 0; f < count; ++f) {
+            float *out = ro + f * outStride;
+            KissFloat::vamp_kiss_fftri
+                (m_iconf,
+                 (const KissFloat::vamp_kiss_fft_cpx *)(ci + f * inStride),
+                 out);
+            for (int i = 0; i < m_n; ++i) {
+                out[i] *= scale;
+            }
+        }
+    }
+    
+private:
+    int m_n;
+    KissFloat::vamp_kiss_fftr_cfg m_fconf;
+    KissFloat::vamp_kiss_fftr_cfg m_iconf;
+};
+
+FFTRealFloat::FFTRealFloat(unsigned int n) :
+    m_d(new D(n))
+{
+}
+
+FFTRealFloat::~FFTRealFloat()
+{
+    delete m_d;
+}
+
+void
+FFTRealFloat::forward(const float *ri, float *co)
+{
+    m_d->forward(ri, 0, co, 0, 1);
+}
+
+void
+FFTRealFloat::inverse(const float *ci, float *ro)
+{
+    m_d->inverse(ci, 0, ro, 0, 1);
+}
+
+void
+FFTRealFloat::forwardBatch(const float *ri, unsigned int inStride,
+                           float *co, unsigned int outStride,
+                           unsigned int count)
+{
+    m_d->forward(ri, inStride, co, outStride, count);
+}
+
+void
+FFTRealFloat::inverseBatch(const float *ci, unsigned int inStride,
+                           float *ro, unsigned int outStride,
+                           unsigned int count)
+{
+    m_d->inverse(ci, inStride, ro, outStride, count);
 }
 
 }
@@ -1,7 +1,12 @@
 
 // Override C linkage for KissFFT headers. So long as we have already
 // included all of the other (system etc) headers KissFFT depends on,
-// this should work out OK
+// this should work out OK. That includes FFTsimd.h, which provides
+// the vectorised butterflies our copy of KissFFT calls if it can
+#ifndef _VAMP_FFT_SIMD_H_
+#error "FFTsimd.h must be included before FFTimpl.cpp"
+#endif
+
 #define VAMP_KISSFFT_USE_CPP_LINKAGE 1
 
 namespace Kiss {
@@ -22,6 +27,28 @@ typedef double vamp_kiss_fft_scalar;
 
 }
 
+// A second instantiation that is always single-precision, for callers
+// that only want float output and would otherwise pay to convert to
+// and from double. The KissFFT headers are only meant to be included
+// once, so clear their include guards before including them again;
+// the macros they define are the same for both instantiations
+
+#undef VAMP_KISS_FFT_H
+#undef VAMP_KISS_FFTR_H
+#undef VAMP_KISS_FFT__GUTS_H
+
+namespace KissFloat {
+
+typedef float vamp_kiss_fft_scalar;
+#define vamp_kiss_fft_scalar float
+
+#include "ext/vamp_kiss_fft.c"
+#include "ext/vamp_kiss_fftr.c"
+
+#undef vamp_kiss_fft_scalar
+
+}
+
 // Check that this worked, i.e. that we have our own suitably
 // hacked KissFFT header which set this after making the
 // appropriate change
@@ -0,0 +1,446 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Vamp
+
+    An API for audio analysis and feature extraction plugins.
+
+    Centre for Digital Music, Queen Mary, University of London.
+    Copyright 2006-2012 Chris Cannam and QMUL.
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and Chris Cannam
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+#ifndef _VAMP_FFT_SIMD_H_
+#define _VAMP_FFT_SIMD_H_
+
+// Vectorised versions of the KissFFT radix-2 and radix-4 butterflies
+// and of the real-FFT post-twiddle, used by the hooks in our copy of
+// KissFFT when VAMP_KISS_FFT_SIMD is defined, together with a
+// magnitude calculation for the FFT output.
+//
+// This header must be included before FFTimpl.cpp and outside any SDK
+// namespace, as it pulls in the compiler's intrinsics headers.
+//
+// SSE2 is always available on x86-64, so it is used unconditionally
+// there. NEON kernels for aarch64 are provided too, but are only used
+// if VAMP_KISS_FFT_NEON is defined when building the SDK; otherwise
+// aarch64 builds use the scalar code. On x86 with GCC or Clang, AVX
+// kernels are compiled as well and chosen at runtime if the CPU and
+// OS support them. The kernels use separate multiplies and adds (no
+// FMA) in the same order as the scalar KissFFT macros, so that their
+// results match the scalar code. Define NO_SIMD_FFT when building the
+// SDK to use the scalar code only, or NO_AVX_FFT to leave out the AVX
+// kernels and use SSE2 alone. The scalar code is also used for
+// unoptimised GCC and Clang builds, in which the intrinsics wrappers
+// end up slower than the plain loops they replace.
+//
+// test/test-fft-simd.cpp checks that the SSE2 and AVX kernels agree
+// with the scalar code. The NEON kernels have never been compiled or
+// tested, which is why they are opt-in: they should only be enabled
+// by default once that test has been built with VAMP_KISS_FFT_NEON
+// and passed on an aarch64 machine.
+
+#if defined(__GNUC__) && !defined(__OPTIMIZE__)
+#define NO_SIMD_FFT 1
+#endif
+
+#ifndef NO_SIMD_FFT
+
+#if defined(__x86_64__) || defined(_M_X64) || \
+    (defined(__i386__) && defined(__SSE2__)) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VAMP_KISS_SIMD_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) && !defined(NO_AVX_FFT) && \
+    (defined(__clang__) || (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define VAMP_KISS_SIMD_AVX 1
+#include <immintrin.h>
+#endif
+#elif defined(VAMP_KISS_FFT_NEON) && \
+    (defined(__aarch64__) || defined(_M_ARM64))
+#define VAMP_KISS_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+#endif
+
+#if defined(VAMP_KISS_SIMD_SSE2) || defined(VAMP_KISS_SIMD_NEON)
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+
+#define VAMP_KISS_FFT_SIMD 1
+
+namespace VampKissSIMD {
+
+/**
+ * Register traits for the kernels in FFTsimdkernels.h. Each provides
+ * the register type R holding N complex values of scalar type S
+ * (interleaved real and imaginary), and the arithmetic the kernels
+ * need. Complex multiplication is arranged so that each lane performs
+ * exactly the same rounding steps as the scalar C_MUL macro.
+ */
+
+#ifdef VAMP_KISS_SIMD_SSE2
+
+struct SSE2Double {
+    typedef double S;
+    typedef __m128d R;
+    enum { N = 1 };
+    static inline R load(const S *p) { return _mm_loadu_pd(p); }
+    static inline void store(S *p, R r) { _mm_storeu_pd(p, r); }
+    static inline R loadStrided(const S *p, size_t) { return _mm_loadu_pd(p); }
+    static inline R add(R a, R b) { return _mm_add_pd(a, b); }
+    static inline R sub(R a, R b) { return _mm_sub_pd(a, b); }
+    static inline R half(R a) { return _mm_mul_pd(a, _mm_set1_pd(0.5)); }
+    static inline R conj(R a) { return _mm_xor_pd(a, _mm_set_pd(-0.0, 0.0)); }
+    static inline R reverse(R a) { return a; }
+    static inline R mulByI(R a) {
+        return _mm_xor_pd(_mm_shuffle_pd(a, a, 1), _mm_set_pd(0.0, -0.0));
+    }
+    static inline R cmul(R a, R w) {
+        R re = _mm_mul_pd(a, _mm_unpacklo_pd(w, w));
+        R im = _mm_mul_pd(_mm_shuffle_pd(a, a, 1), _mm_unpackhi_pd(w, w));
+        return _mm_add_pd(re, _mm_xor_pd(im, _mm_set_pd(0.0, -0.0)));
+    }
+};
+
+struct SSE2Float {
+    typedef float S;
+    typedef __m128 R;
+    enum { N = 2 };
+    static inline R load(const S *p) { return _mm_loadu_ps(p); }
+    static inline void store(S *p, R r) { _mm_storeu_ps(p, r); }
+    static inline R loadStrided(const S *p, size_t stride) {
+        R r = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)p);
+        return _mm_loadh_pi(r, (const __m64 *)(p + 2 * stride));
+    }
+    static inline R add(R a, R b) { return _mm_add_ps(a, b); }
+    static inline R sub(R a, R b) { return _mm_sub_ps(a, b); }
+    static inline R half(R a) { return _mm_mul_ps(a, _mm_set1_ps(0.5f)); }
+    static inline R conj(R a) {
+        return _mm_xor_ps(a, _mm_set_ps(-0.f, 0.f, -0.f, 0.f));
+    }
+    static inline R reverse(R a) {
+        return _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 3, 2));
+    }
+    static inline R mulByI(R a) {
+        return _mm_xor_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)),
+                          _mm_set_ps(0.f, -0.f, 0.f, -0.f));
+    }
+    static inline R cmul(R a, R w) {
+        R re = _mm_mul_ps(a, _mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 0, 0)));
+        R im = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)),
+                          _mm_shuffle_ps(w, w, _MM_SHUFFLE(3, 3, 1, 1)));
+        return _mm_add_ps(re, _mm_xor_ps(im, _mm_set_ps(0.f, -0.f, 0.f, -0.f)));
+    }
+};
+
+#endif
+
+#ifdef VAMP_KISS_SIMD_AVX
+
+#define VAMP_KISS_SIMD_AVX_TARGET __attribute__((target("avx")))
+
+struct AVXDouble {
+    typedef double S;
+    typedef __m256d R;
+    enum { N = 2 };
+    VAMP_KISS_SIMD_AVX_TARGET static inline R load(const S *p) {
+        return _mm256_loadu_pd(p);
+    }
+    VAMP_KISS_SIMD_AVX_TARGET static inline void store(S *p, R r) {
+        _mm256_storeu_pd(p, r);
+    }
+    VAMP_KISS_SIMD_AVX_TARGET static inline R loadStrided(const S *p, size_t stride) {
+        return _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(p)),
+                                    _mm_loadu_pd(p + 2 * stride), 1);
+    }
+    VAMP_KISS_SIMD_AVX_TARGET static inline R add(R a, R b) {
+        return _mm256_add_pd(a, b);
+    }
+    VAMP_KISS_SIMD_AVX_TARGET static inline R sub(R a, R b) {
+        return _mm256_sub_pd(a, b);
+    }
+    VAMP_KISS_SIMD_AVX_TARGET static inline R half(R a) {
+        return _mm256_mul_pd(a, _mm256_set1_pd(0.5));
+    }
+    VAMP_KISS_SIMD_AVX_TARGET static inline R conj(R a) {
+        return _mm256_xor_pd(a, _mm256_set_pd(-0.0, 0.0, -0.0, 0.0));
+    }
+    VAMP_KISS_SIMD_AVX_TARGET static inline R reverse(R a) {
+        return _mm256_permute2f128_pd(a, a, 1);
+    }
+    VAMP_KISS_SIMD_AVX_TARGET static inline R mulByI(R a) {
+        return _mm256_xor_pd(_mm256_permute_pd(a, 0x5),
+                             _mm256_set_pd(0.0, -0.0, 0.0, -0.0));
+    }
+    VAMP_KISS_SIMD_AVX_TARGET static inline R cmul(R a, R w) {
+        R re = _mm256_mul_pd(a, _mm256_movedup_pd(w));
+        R im = _mm256_mul_pd(_mm256_permute_pd(a, 0x5),
+                             _mm256_permute_pd(w, 0xf));
+        return _mm256_addsub_pd(re, im);
+    }
+};
+
+struct AVXFloat {
+    typedef float S;
+    typedef __m256 R;
+    enum { N = 4 };
+    VAMP_KISS_SIMD_AVX_TARGET static inline R load(const S *p) {
+        return _mm256_loadu_ps(p);
+    }
+    VAMP_KISS_SIMD_AVX_TARGET static inline void store(S *p, R r) {
+        _mm256_storeu_ps(p, r);
+    }
+    VAMP_KISS_SIMD_AVX_TARGET static inline R loadStrided(const S *p, size_t stride) {
+        if (stride == 1) return _mm256_loadu_ps(p);
+        __m128 lo = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)p);
+        lo = _mm_loadh_pi(lo, (const __m64 *)(p + 2 * stride));
+        __m128 hi = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)(p + 4 * stride));
+        hi = _mm_loadh_pi(hi, (const __m64 *)(p + 6 * stride));
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+    }
+    VAMP_KISS_SIMD_AVX_TARGET static inline R add(R a, R b) {
+        return _mm256_add_ps(a, b);
+    }
+    VAMP_KISS_SIMD_AVX_TARGET static inline R sub(R a, R b) {
+        return _mm256_sub_ps(a, b);
+    }
+    VAMP_KISS_SIMD_AVX_TARGET static inline R half(R a) {
+        return _mm256_mul_ps(a, _mm256_set1_ps(0.5f));
+    }
+    VAMP_KISS_SIMD_AVX_TARGET static inline R conj(R a) {
+        return _mm256_xor_ps(a, _mm256_set_ps(-0.f, 0.f, -0.f, 0.f,
+                                              -0.f, 0.f, -0.f, 0.f));
+    }
+    VAMP_KISS_SIMD_AVX_TARGET static inline R reverse(R a) {
+        R swapped = _mm256_permute2f128_ps(a, a, 1);
+        return _mm256_permute_ps(swapped, _MM_SHUFFLE(1, 0, 3, 2));
+    }
+    VAMP_KISS_SIMD_AVX_TARGET static inline R mulByI(R a) {
+        return _mm256_xor_ps(_mm256_permute_ps(a, _MM_SHUFFLE(2, 3, 0, 1)),
+                             _mm256_set_ps(0.f, -0.f, 0.f, -0.f,
+                                           0.f, -0.f, 0.f, -0.f));
+    }
+    VAMP_KISS_SIMD_AVX_TARGET static inline R cmul(R a, R w) {
+        R re = _mm256_mul_ps(a, _mm256_moveldup_ps(w));
+        R im = _mm256_mul_ps(_mm256_permute_ps(a, _MM_SHUFFLE(2, 3, 0, 1)),
+                             _mm256_movehdup_ps(w));
+        return _mm256_addsub_ps(re, im);
+    }
+};
+
+#endif
+
+#ifdef VAMP_KISS_SIMD_NEON
+
+// Unverified: see the note at the top of this file
+
+struct NEONDouble {
+    typedef double S;
+    typedef float64x2_t R;
+    enum { N = 1 };
+    static inline R load(const S *p) { return vld1q_f64(p); }
+    static inline void store(S *p, R r) { vst1q_f64(p, r); }
+    static inline R loadStrided(const S *p, size_t) { return vld1q_f64(p); }
+    static inline R add(R a, R b) { return vaddq_f64(a, b); }
+    static inline R sub(R a, R b) { return vsubq_f64(a, b); }
+    static inline R half(R a) { return vmulq_n_f64(a, 0.5); }
+    static inline R negate(R a, uint64_t lo, uint64_t hi) {
+        uint64x2_t mask = vcombine_u64(vcreate_u64(lo), vcreate_u64(hi));
+        return vreinterpretq_f64_u64(veorq_u64(vreinterpretq_u64_f64(a), mask));
+    }
+    static inline R conj(R a) { return negate(a, 0, 1ULL << 63); }
+    static inline R reverse(R a) { return a; }
+    static inline R mulByI(R a) {
+        return negate(vextq_f64(a, a, 1), 1ULL << 63, 0);
+    }
+    static inline R cmul(R a, R w) {
+        R re = vmulq_f64(a, vdupq_laneq_f64(w, 0));
+        R im = vmulq_f64(vextq_f64(a, a, 1), vdupq_laneq_f64(w, 1));
+        return vaddq_f64(re, negate(im, 1ULL << 63, 0));
+    }
+};
+
+struct NEONFloat {
+    typedef float S;
+    typedef float32x4_t R;
+    enum { N = 2 };
+    static inline R load(const S *p) { return vld1q_f32(p); }
+    static inline void store(S *p, R r) { vst1q_f32(p, r); }
+    static inline R loadStrided(const S *p, size_t stride) {
+        return vcombine_f32(vld1_f32(p), vld1_f32(p + 2 * stride));
+    }
+    static inline R add(R a, R b) { return vaddq_f32(a, b); }
+    static inline R sub(R a, R b) { return vsubq_f32(a, b); }
+    static inline R half(R a) { return vmulq_n_f32(a, 0.5f); }
+    static inline R negate(R a, uint32_t even, uint32_t odd) {
+        uint32x2_t pair = vcreate_u32(uint64_t(even) | (uint64_t(odd) << 32));
+        uint32x4_t mask = vcombine_u32(pair, pair);
+        return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a), mask));
+    }
+    static inline R conj(R a) { return negate(a, 0, 0x80000000u); }
+    static inline R reverse(R a) { return vextq_f32(a, a, 2); }
+    static inline R mulByI(R a) {
+        return negate(vrev64q_f32(a), 0x80000000u, 0);
+    }
+    static inline R cmul(R a, R w) {
+        R re = vmulq_f32(a, vtrn1q_f32(w, w));
+        R im = vmulq_f32(vrev64q_f32(a), vtrn2q_f32(w, w));
+        return vaddq_f32(re, negate(im, 0x80000000u, 0));
+    }
+};
+
+#endif
+
+// The kernels themselves are written once as templates over the
+// traits above, and instantiated a second time with the AVX target
+// attribute applied so that they can be used with the AVX traits
+
+#define VAMP_KISS_SIMD_TARGET
+
+namespace Baseline {
+#include "FFTsimdkernels.h"
+}
+
+#undef VAMP_KISS_SIMD_TARGET
+
+#ifdef VAMP_KISS_SIMD_AVX
+
+#define VAMP_KISS_SIMD_TARGET VAMP_KISS_SIMD_AVX_TARGET
+
+namespace AVX {
+#include "FFTsimdkernels.h"
+}
+
+#undef VAMP_KISS_SIMD_TARGET
+
+static inline bool
+haveAVX()
+{
+    static const bool have = __builtin_cpu_supports("avx");
+    return have;
+}
+
+#endif
+
+#ifdef VAMP_KISS_SIMD_SSE2
+typedef SSE2Double BaselineDouble;
+typedef SSE2Float BaselineFloat;
+#else
+typedef NEONDouble BaselineDouble;
+typedef NEONFloat BaselineFloat;
+#endif
+
+#ifdef VAMP_KISS_SIMD_AVX
+#define VAMP_KISS_SIMD_DISPATCH(fn, type, args) \
+    if (haveAVX()) AVX::fn<AVX##type> args; \
+    else Baseline::fn<Baseline##type> args;
+#else
+#define VAMP_KISS_SIMD_DISPATCH(fn, type, args) \
+    Baseline::fn<Baseline##type> args;
+#endif
+
+static inline void
+bfly2(double *fout, const double *tw, size_t fstride, size_t m)
+{
+    VAMP_KISS_SIMD_DISPATCH(bfly2, Double, (fout, tw, fstride, m))
+}
+
+static inline void
+bfly2(float *fout, const float *tw, size_t fstride, size_t m)
+{
+    VAMP_KISS_SIMD_DISPATCH(bfly2, Float, (fout, tw, fstride, m))
+}
+
+static inline void
+bfly4(double *fout, const double *tw, size_t fstride, size_t m, bool inverse)
+{
+    VAMP_KISS_SIMD_DISPATCH(bfly4, Double, (fout, tw, fstride, m, inverse))
+}
+
+static inline void
+bfly4(float *fout, const float *tw, size_t fstride, size_t m, bool inverse)
+{
+    VAMP_KISS_SIMD_DISPATCH(bfly4, Float, (fout, tw, fstride, m, inverse))
+}
+
+static inline void
+realPostTwiddle(double *freq, const double *tmp, const double *tw, int ncfft)
+{
+    VAMP_KISS_SIMD_DISPATCH(realPostTwiddle, Double, (freq, tmp, tw, ncfft))
+}
+
+static inline void
+realPostTwiddle(float *freq, const float *tmp, const float *tw, int ncfft)
+{
+    VAMP_KISS_SIMD_DISPATCH(realPostTwiddle, Float, (freq, tmp, tw, ncfft))
+}
+
+#undef VAMP_KISS_SIMD_DISPATCH
+
+/**
+ * Calculate the magnitudes of n interleaved complex values. The
+ * vector square root is correctly rounded, so on x86 the results
+ * match sqrtf(re * re + im * im) exactly.
+ */
+static inline void
+magnitudes(const float *cplx, float *mag, int n)
+{
+    int i = 0;
+
+#ifdef VAMP_KISS_SIMD_SSE2
+    for (; i + 4 <= n; i += 4) {
+        __m128 a = _mm_loadu_ps(cplx + 2 * i);
+        __m128 b = _mm_loadu_ps(cplx + 2 * i + 4);
+        __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 sq = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+        _mm_storeu_ps(mag + i, _mm_sqrt_ps(sq));
+    }
+#else
+    for (; i + 4 <= n; i += 4) {
+        float32x4x2_t c = vld2q_f32(cplx + 2 * i);
+        float32x4_t sq = vaddq_f32(vmulq_f32(c.val[0], c.val[0]),
+                                   vmulq_f32(c.val[1], c.val[1]));
+        vst1q_f32(mag + i, vsqrtq_f32(sq));
+    }
+#endif
+
+    for (; i < n; ++i) {
+        float re = cplx[2 * i], im = cplx[2 * i + 1];
+        mag[i] = sqrtf(re * re + im * im);
+    }
+}
+
+}
+
+#endif
+
+#endif
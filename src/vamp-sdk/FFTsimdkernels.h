@@ -0,0 +1,196 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Vamp
+
+    An API for audio analysis and feature extraction plugins.
+
+    Centre for Digital Music, Queen Mary, University of London.
+    Copyright 2006-2012 Chris Cannam and QMUL.
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and Chris Cannam
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+// No include guard: this file is included by FFTsimd.h once for each
+// instruction set, with VAMP_KISS_SIMD_TARGET set to the appropriate
+// function attribute. Complex arrays are passed as pointers to their
+// first scalar, with real and imaginary parts interleaved.
+//
+// Each kernel handles V::N complex values per step and finishes any
+// remainder with scalar code that follows the KissFFT macros exactly.
+
+template <typename S>
+VAMP_KISS_SIMD_TARGET static inline void
+cmulScalar(S &mr, S &mi, S ar, S ai, const S *w)
+{
+    mr = ar * w[0] - ai * w[1];
+    mi = ar * w[1] + ai * w[0];
+}
+
+/**
+ * Radix-2 butterfly, equivalent to kf_bfly2.
+ */
+template <typename V>
+VAMP_KISS_SIMD_TARGET static void
+bfly2(typename V::S *fout, const typename V::S *tw, size_t fstride, size_t m)
+{
+    typedef typename V::S S;
+    typedef typename V::R R;
+
+    S *fout2 = fout + 2 * m;
+    size_t k = 0;
+
+    for (; k + V::N <= m; k += V::N) {
+        R a = V::load(fout + 2 * k);
+        R t = V::cmul(V::load(fout2 + 2 * k),
+                      V::loadStrided(tw + 2 * k * fstride, fstride));
+        V::store(fout2 + 2 * k, V::sub(a, t));
+        V::store(fout + 2 * k, V::add(a, t));
+    }
+
+    for (; k < m; ++k) {
+        S tr, ti;
+        cmulScalar(tr, ti, fout2[2*k], fout2[2*k+1], tw + 2 * k * fstride);
+        fout2[2*k] = fout[2*k] - tr;
+        fout2[2*k+1] = fout[2*k+1] - ti;
+        fout[2*k] += tr;
+        fout[2*k+1] += ti;
+    }
+}
+
+/**
+ * Radix-4 butterfly, equivalent to kf_bfly4.
+ */
+template <typename V>
+VAMP_KISS_SIMD_TARGET static void
+bfly4(typename V::S *fout, const typename V::S *tw, size_t fstride, size_t m,
+      bool inverse)
+{
+    typedef typename V::S S;
+    typedef typename V::R R;
+
+    S *fout1 = fout + 2 * m;
+    S *fout2 = fout + 4 * m;
+    S *fout3 = fout + 6 * m;
+    size_t k = 0;
+
+    for (; k + V::N <= m; k += V::N) {
+        size_t i = 2 * k;
+        R s0 = V::cmul(V::load(fout1 + i),
+                       V::loadStrided(tw + i * fstride, fstride));
+        R s1 = V::cmul(V::load(fout2 + i),
+                       V::loadStrided(tw + 2 * i * fstride, 2 * fstride));
+        R s2 = V::cmul(V::load(fout3 + i),
+                       V::loadStrided(tw + 3 * i * fstride, 3 * fstride));
+        R f0 = V::load(fout + i);
+        R s5 = V::sub(f0, s1);
+        f0 = V::add(f0, s1);
+        R s3 = V::add(s0, s2);
+        R s4 = V::mulByI(V::sub(s0, s2));
+        V::store(fout2 + i, V::sub(f0, s3));
+        V::store(fout + i, V::add(f0, s3));
+        if (inverse) {
+            V::store(fout1 + i, V::add(s5, s4));
+            V::store(fout3 + i, V::sub(s5, s4));
+        } else {
+            V::store(fout1 + i, V::sub(s5, s4));
+            V::store(fout3 + i, V::add(s5, s4));
+        }
+    }
+
+    for (; k < m; ++k) {
+        size_t i = 2 * k;
+        S s0r, s0i, s1r, s1i, s2r, s2i;
+        cmulScalar(s0r, s0i, fout1[i], fout1[i+1], tw + i * fstride);
+        cmulScalar(s1r, s1i, fout2[i], fout2[i+1], tw + 2 * i * fstride);
+        cmulScalar(s2r, s2i, fout3[i], fout3[i+1], tw + 3 * i * fstride);
+        S s5r = fout[i] - s1r, s5i = fout[i+1] - s1i;
+        fout[i] += s1r;
+        fout[i+1] += s1i;
+        S s3r = s0r + s2r, s3i = s0i + s2i;
+        S s4r = s0r - s2r, s4i = s0i - s2i;
+        fout2[i] = fout[i] - s3r;
+        fout2[i+1] = fout[i+1] - s3i;
+        fout[i] += s3r;
+        fout[i+1] += s3i;
+        if (inverse) {
+            fout1[i] = s5r - s4i;
+            fout1[i+1] = s5i + s4r;
+            fout3[i] = s5r + s4i;
+            fout3[i+1] = s5i - s4r;
+        } else {
+            fout1[i] = s5r + s4i;
+            fout1[i+1] = s5i - s4r;
+            fout3[i] = s5r - s4i;
+            fout3[i+1] = s5i + s4r;
+        }
+    }
+}
+
+/**
+ * The loop over bins 1 to ncfft/2 in vamp_kiss_fftr, which separates
+ * the half-length complex FFT in tmp into the real FFT output in
+ * freq. Bin k and bin ncfft-k are written together, so vectors are
+ * only used while the two ranges cannot overlap; the middle bin is
+ * left to the scalar loop, where (as in KissFFT) its second write
+ * wins.
+ */
+template <typename V>
+VAMP_KISS_SIMD_TARGET static void
+realPostTwiddle(typename V::S *freq, const typename V::S *tmp,
+                const typename V::S *tw, int ncfft)
+{
+    typedef typename V::S S;
+    typedef typename V::R R;
+
+    int k = 1;
+
+    for (; 2 * (k + V::N - 1) < ncfft; k += V::N) {
+        int nk = ncfft - k - V::N + 1;
+        R fpk = V::load(tmp + 2 * k);
+        R fpnk = V::conj(V::reverse(V::load(tmp + 2 * nk)));
+        R f1k = V::add(fpk, fpnk);
+        R f2k = V::sub(fpk, fpnk);
+        R t = V::cmul(f2k, V::load(tw + 2 * (k - 1)));
+        V::store(freq + 2 * k, V::half(V::add(f1k, t)));
+        V::store(freq + 2 * nk,
+                 V::reverse(V::half(V::sub(V::conj(f1k), V::conj(t)))));
+    }
+
+    for (; k <= ncfft / 2; ++k) {
+        int nk = ncfft - k;
+        S fpkr = tmp[2*k], fpki = tmp[2*k+1];
+        S fpnkr = tmp[2*nk], fpnki = -tmp[2*nk+1];
+        S f1kr = fpkr + fpnkr, f1ki = fpki + fpnki;
+        S f2kr = fpkr - fpnkr, f2ki = fpki - fpnki;
+        S tr, ti;
+        cmulScalar(tr, ti, f2kr, f2ki, tw + 2 * (k - 1));
+        freq[2*k] = (f1kr + tr) * S(0.5);
+        freq[2*k+1] = (f1ki + ti) * S(0.5);
+        freq[2*nk] = (f1kr - tr) * S(0.5);
+        freq[2*nk+1] = (ti - f1ki) * S(0.5);
+    }
+}
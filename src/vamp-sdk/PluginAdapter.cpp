@@ -107,20 +107,57 @@ protected:
 
     static void vampReleaseFeatureSet(VampFeatureList *fs);
 
-    void checkOutputMap(Plugin *plugin);
-    void markOutputsChanged(Plugin *plugin);
-
-    void cleanup(Plugin *plugin);
-    unsigned int getOutputCount(Plugin *plugin);
-    VampOutputDescriptor *getOutputDescriptor(Plugin *plugin, unsigned int i);
-    VampFeatureList *process(Plugin *plugin,
+    /**
+     * The state belonging to a single plugin instance. The handle we
+     * give to the host is a pointer to one of these, so each instance
+     * reaches its adapter, output list and feature conversion arena
+     * directly, without any lock or map lookup. The host may not call
+     * into the same instance from more than one thread at once, so
+     * none of this needs guarding.
+     *
+     * The C output descriptors are converted on first request and
+     * kept until the outputs change. Those in use at that point move
+     * to staleDescriptors, as the host may still be looking at one;
+     * they are freed at the next getOutputDescriptor call, which is
+     * as long as the API promises they remain valid.
+     */
+    struct Instance {
+        Instance(Impl *a, Plugin *p) :
+            adapter(a), plugin(p), outputs(0), arena(0), arenaSize(0) { }
+        ~Instance();
+        
+        Impl *adapter;
+        Plugin *plugin;
+        Plugin::OutputList *outputs;
+        vector<VampOutputDescriptor *> descriptors;
+        vector<VampOutputDescriptor *> staleDescriptors;
+
+        // Holds the feature set returned from the latest process or
+        // getRemainingFeatures call, which the host may use only
+        // until the next one; reused, and grown only when too small
+        char *arena;
+        size_t arenaSize;
+    };
+
+    void checkOutputMap(Instance *instance);
+    void markOutputsChanged(Instance *instance);
+
+    static VampOutputDescriptor *convertOutputDescriptor
+    (const Plugin::OutputDescriptor &od);
+    static void releaseOutputDescriptor(VampOutputDescriptor *desc);
+    static void releaseOutputDescriptors(vector<VampOutputDescriptor *> &);
+
+    unsigned int getOutputCount(Instance *instance);
+    VampOutputDescriptor *getOutputDescriptor(Instance *instance,
+                                              unsigned int i);
+    VampFeatureList *process(Instance *instance,
                              const float *const *inputBuffers,
                              int sec, int nsec);
-    VampFeatureList *getRemainingFeatures(Plugin *plugin);
-    VampFeatureList *convertFeatures(Plugin *plugin,
+    VampFeatureList *getRemainingFeatures(Instance *instance);
+    VampFeatureList *convertFeatures(Instance *instance,
                                      const Plugin::FeatureSet &features);
     
-    // maps both plugins and descriptors to adapters
+    // maps descriptors to adapters, for use in vampInstantiate
     typedef map<const void *, Impl *> AdapterMap;
 
     static AdapterMap *m_adapterMap;
@@ -128,7 +165,7 @@ protected:
     static mutex &adapterMapMutex() {
         // If this mutex was a global static, then it might be
         // destroyed before the last adapter, and we would end up
-        // trying to lock an invalid mutex when removing an adapter
+        // trying to lock an invalid mutex when removing the adapter
         // from the adapter map. To ensure it outlasts the adapters,
         // we need to ensure it is constructed before the construction
         // of any of them is complete, since destruction order is
@@ -137,8 +174,7 @@ protected:
         static mutex m;
         return m;
     }
-        
-    static Impl *lookupAdapter(VampPluginHandle);
+
 
     mutex m_mutex; // guards all of the below
     
@@ -146,16 +182,11 @@ protected:
     VampPluginDescriptor m_descriptor;
     Plugin::ParameterList m_parameters;
     Plugin::ProgramList m_programs;
-    
-    typedef map<Plugin *, Plugin::OutputList *> OutputMap;
-    OutputMap m_pluginOutputs;
-
-    map<Plugin *, VampFeatureList *> m_fs;
-    map<Plugin *, vector<size_t> > m_fsizes;
-    map<Plugin *, vector<vector<size_t> > > m_fvsizes;
-    void resizeFS(Plugin *plugin, int n);
-    void resizeFL(Plugin *plugin, int n, size_t sz);
-    void resizeFV(Plugin *plugin, int n, int j, size_t sz);
+
+    static size_t alignArena(size_t n) {
+        return (n + 15) & ~size_t(15);
+    }
+    static char *reserveArena(Instance *instance, size_t size);
 };
 
 PluginAdapterBase::PluginAdapterBase()
@@ -353,21 +384,6 @@ PluginAdapterBase::Impl::~Impl()
     }
 }
 
-PluginAdapterBase::Impl *
-PluginAdapterBase::Impl::lookupAdapter(VampPluginHandle handle)
-{
-#ifdef DEBUG_PLUGIN_ADAPTER
-    cerr << "PluginAdapterBase::Impl::lookupAdapter(" << handle << ")" << endl;
-#endif
-
-    lock_guard<mutex> adapterMapGuard(adapterMapMutex());
-    
-    if (!m_adapterMap) return 0;
-    AdapterMap::const_iterator i = m_adapterMap->find(handle);
-    if (i == m_adapterMap->end()) return 0;
-    return i->second;
-}
-
 VampPluginHandle
 PluginAdapterBase::Impl::vampInstantiate(const VampPluginDescriptor *desc,
                                          float inputSampleRate)
@@ -376,30 +392,35 @@ PluginAdapterBase::Impl::vampInstantiate(const VampPluginDescriptor *desc,
     cerr << "PluginAdapterBase::Impl::vampInstantiate(" << desc << ")" << endl;
 #endif
 
-    lock_guard<mutex> adapterMapGuard(adapterMapMutex());
+    Impl *adapter = 0;
+
+    {
+        lock_guard<mutex> adapterMapGuard(adapterMapMutex());
     
-    if (!m_adapterMap) {
-        m_adapterMap = new AdapterMap();
-    }
+        AdapterMap::const_iterator i;
+        if (!m_adapterMap ||
+            (i = m_adapterMap->find(desc)) == m_adapterMap->end()) {
+            cerr << "WARNING: PluginAdapterBase::Impl::vampInstantiate: Descriptor " << desc << " not in adapter map" << endl;
+            return 0;
+        }
 
-    if (m_adapterMap->find(desc) == m_adapterMap->end()) {
-        cerr << "WARNING: PluginAdapterBase::Impl::vampInstantiate: Descriptor " << desc << " not in adapter map" << endl;
-        return 0;
+        adapter = i->second;
+        if (desc != &adapter->m_descriptor) return 0;
     }
 
-    Impl *adapter = (*m_adapterMap)[desc];
-    if (desc != &adapter->m_descriptor) return 0;
+    // Each instance then carries its adapter with it, so no call
+    // made through the handle needs the adapter map again
 
     Plugin *plugin = adapter->m_base->createPlugin(inputSampleRate);
-    if (plugin) {
-        (*m_adapterMap)[plugin] = adapter;
-    }
+    if (!plugin) return 0;
+
+    Instance *instance = new Instance(adapter, plugin);
 
 #ifdef DEBUG_PLUGIN_ADAPTER
-    cerr << "PluginAdapterBase::Impl::vampInstantiate(" << desc << "): returning handle " << plugin << endl;
+    cerr << "PluginAdapterBase::Impl::vampInstantiate(" << desc << "): returning handle " << instance << endl;
 #endif
 
-    return plugin;
+    return instance;
 }
 
 void
@@ -409,12 +430,7 @@ PluginAdapterBase::Impl::vampCleanup(VampPluginHandle handle)
     cerr << "PluginAdapterBase::Impl::vampCleanup(" << handle << ")" << endl;
 #endif
 
-    Impl *adapter = lookupAdapter(handle);
-    if (!adapter) {
-        delete ((Plugin *)handle);
-        return;
-    }
-    adapter->cleanup(((Plugin *)handle));
+    delete ((Instance *)handle);
 }
 
 int
@@ -427,10 +443,9 @@ PluginAdapterBase::Impl::vampInitialise(VampPluginHandle handle,
     cerr << "PluginAdapterBase::Impl::vampInitialise(" << handle << ", " << channels << ", " << stepSize << ", " << blockSize << ")" << endl;
 #endif
 
-    Impl *adapter = lookupAdapter(handle);
-    if (!adapter) return 0;
-    bool result = ((Plugin *)handle)->initialise(channels, stepSize, blockSize);
-    adapter->markOutputsChanged((Plugin *)handle);
+    Instance *instance = (Instance *)handle;
+    bool result = instance->plugin->initialise(channels, stepSize, blockSize);
+    instance->adapter->markOutputsChanged(instance);
     return result ? 1 : 0;
 }
 
@@ -441,7 +456,7 @@ PluginAdapterBase::Impl::vampReset(VampPluginHandle handle)
     cerr << "PluginAdapterBase::Impl::vampReset(" << handle << ")" << endl;
 #endif
 
-    ((Plugin *)handle)->reset();
+    ((Instance *)handle)->plugin->reset();
 }
 
 float
@@ -452,10 +467,9 @@ PluginAdapterBase::Impl::vampGetParameter(VampPluginHandle handle,
     cerr << "PluginAdapterBase::Impl::vampGetParameter(" << handle << ", " << param << ")" << endl;
 #endif
 
-    Impl *adapter = lookupAdapter(handle);
-    if (!adapter) return 0.0;
-    Plugin::ParameterList &list = adapter->m_parameters;
-    return ((Plugin *)handle)->getParameter(list[param].identifier);
+    Instance *instance = (Instance *)handle;
+    Plugin::ParameterList &list = instance->adapter->m_parameters;
+    return instance->plugin->getParameter(list[param].identifier);
 }
 
 void
@@ -466,11 +480,10 @@ PluginAdapterBase::Impl::vampSetParameter(VampPluginHandle handle,
     cerr << "PluginAdapterBase::Impl::vampSetParameter(" << handle << ", " << param << ", " << value << ")" << endl;
 #endif
 
-    Impl *adapter = lookupAdapter(handle);
-    if (!adapter) return;
-    Plugin::ParameterList &list = adapter->m_parameters;
-    ((Plugin *)handle)->setParameter(list[param].identifier, value);
-    adapter->markOutputsChanged((Plugin *)handle);
+    Instance *instance = (Instance *)handle;
+    Plugin::ParameterList &list = instance->adapter->m_parameters;
+    instance->plugin->setParameter(list[param].identifier, value);
+    instance->adapter->markOutputsChanged(instance);
 }
 
 unsigned int
@@ -480,10 +493,9 @@ PluginAdapterBase::Impl::vampGetCurrentProgram(VampPluginHandle handle)
     cerr << "PluginAdapterBase::Impl::vampGetCurrentProgram(" << handle << ")" << endl;
 #endif
 
-    Impl *adapter = lookupAdapter(handle);
-    if (!adapter) return 0;
-    Plugin::ProgramList &list = adapter->m_programs;
-    string program = ((Plugin *)handle)->getCurrentProgram();
+    Instance *instance = (Instance *)handle;
+    Plugin::ProgramList &list = instance->adapter->m_programs;
+    string program = instance->plugin->getCurrentProgram();
     for (unsigned int i = 0; i < list.size(); ++i) {
         if (list[i] == program) return i;
     }
@@ -498,13 +510,11 @@ PluginAdapterBase::Impl::vampSelectProgram(VampPluginHandle handle,
     cerr << "PluginAdapterBase::Impl::vampSelectProgram(" << handle << ", " << program << ")" << endl;
 #endif
 
-    Impl *adapter = lookupAdapter(handle);
-    if (!adapter) return;
-
-    Plugin::ProgramList &list = adapter->m_programs;
-    ((Plugin *)handle)->selectProgram(list[program]);
+    Instance *instance = (Instance *)handle;
+    Plugin::ProgramList &list = instance->adapter->m_programs;
+    instance->plugin->selectProgram(list[program]);
 
-    adapter->markOutputsChanged((Plugin *)handle);
+    instance->adapter->markOutputsChanged(instance);
 }
 
 unsigned int
@@ -514,7 +524,7 @@ PluginAdapterBase::Impl::vampGetPreferredStepSize(VampPluginHandle handle)
     cerr << "PluginAdapterBase::Impl::vampGetPreferredStepSize(" << handle << ")" << endl;
 #endif
 
-    return ((Plugin *)handle)->getPreferredStepSize();
+    return ((Instance *)handle)->plugin->getPreferredStepSize();
 }
 
 unsigned int
@@ -524,7 +534,7 @@ PluginAdapterBase::Impl::vampGetPreferredBlockSize(VampPluginHandle handle)
     cerr << "PluginAdapterBase::Impl::vampGetPreferredBlockSize(" << handle << ")" << endl;
 #endif
 
-    return ((Plugin *)handle)->getPreferredBlockSize();
+    return ((Instance *)handle)->plugin->getPreferredBlockSize();
 }
 
 unsigned int
@@ -534,7 +544,7 @@ PluginAdapterBase::Impl::vampGetMinChannelCount(VampPluginHandle handle)
     cerr << "PluginAdapterBase::Impl::vampGetMinChannelCount(" << handle << ")" << endl;
 #endif
 
-    return ((Plugin *)handle)->getMinChannelCount();
+    return ((Instance *)handle)->plugin->getMinChannelCount();
 }
 
 unsigned int
@@ -544,7 +554,7 @@ PluginAdapterBase::Impl::vampGetMaxChannelCount(VampPluginHandle handle)
     cerr << "PluginAdapterBase::Impl::vampGetMaxChannelCount(" << handle << ")" << endl;
 #endif
 
-    return ((Plugin *)handle)->getMaxChannelCount();
+    return ((Instance *)handle)->plugin->getMaxChannelCount();
 }
 
 unsigned int
@@ -554,12 +564,8 @@ PluginAdapterBase::Impl::vampGetOutputCount(VampPluginHandle handle)
     cerr << "PluginAdapterBase::Impl::vampGetOutputCount(" << handle << ")" << endl;
 #endif
 
-    Impl *adapter = lookupAdapter(handle);
-
-//    cerr << "vampGetOutputCount: handle " << handle << " -> adapter "<< adapter << endl;
-
-    if (!adapter) return 0;
-    return adapter->getOutputCount((Plugin *)handle);
+    Instance *instance = (Instance *)handle;
+    return instance->adapter->getOutputCount(instance);
 }
 
 VampOutputDescriptor *
@@ -570,21 +576,25 @@ PluginAdapterBase::Impl::vampGetOutputDescriptor(VampPluginHandle handle,
     cerr << "PluginAdapterBase::Impl::vampGetOutputDescriptor(" << handle << ", " << i << ")" << endl;
 #endif
 
-    Impl *adapter = lookupAdapter(handle);
-
-//    cerr << "vampGetOutputDescriptor: handle " << handle << " -> adapter "<< adapter << endl;
-
-    if (!adapter) return 0;
-    return adapter->getOutputDescriptor((Plugin *)handle, i);
+    Instance *instance = (Instance *)handle;
+    return instance->adapter->getOutputDescriptor(instance, i);
 }
 
 void
-PluginAdapterBase::Impl::vampReleaseOutputDescriptor(VampOutputDescriptor *desc)
+PluginAdapterBase::Impl::vampReleaseOutputDescriptor(VampOutputDescriptor *)
 {
 #ifdef DEBUG_PLUGIN_ADAPTER
-    cerr << "PluginAdapterBase::Impl::vampReleaseOutputDescriptor(" << desc << ")" << endl;
+    cerr << "PluginAdapterBase::Impl::vampReleaseOutputDescriptor" << endl;
 #endif
 
+    // Nothing to do here: the descriptors we return belong to their
+    // instance, and are freed when its outputs change or it is
+    // cleaned up
+}
+
+void
+PluginAdapterBase::Impl::releaseOutputDescriptor(VampOutputDescriptor *desc)
+{
     if (desc->identifier) free((void *)desc->identifier);
     if (desc->name) free((void *)desc->name);
     if (desc->description) free((void *)desc->description);
@@ -600,6 +610,15 @@ PluginAdapterBase::Impl::vampReleaseOutputDescriptor(VampOutputDescriptor *desc)
     free((void *)desc);
 }
 
+void
+PluginAdapterBase::Impl::releaseOutputDescriptors(vector<VampOutputDescriptor *> &descs)
+{
+    for (size_t i = 0; i < descs.size(); ++i) {
+        if (descs[i]) releaseOutputDescriptor(descs[i]);
+    }
+    descs.clear();
+}
+
 VampFeatureList *
 PluginAdapterBase::Impl::vampProcess(VampPluginHandle handle,
                                      const float *const *inputBuffers,
@@ -610,9 +629,8 @@ PluginAdapterBase::Impl::vampProcess(VampPluginHandle handle,
     cerr << "PluginAdapterBase::Impl::vampProcess(" << handle << ", " << sec << ", " << nsec << ")" << endl;
 #endif
 
-    Impl *adapter = lookupAdapter(handle);
-    if (!adapter) return 0;
-    return adapter->process((Plugin *)handle, inputBuffers, sec, nsec);
+    Instance *instance = (Instance *)handle;
+    return instance->adapter->process(instance, inputBuffers, sec, nsec);
 }
 
 VampFeatureList *
@@ -622,9 +640,8 @@ PluginAdapterBase::Impl::vampGetRemainingFeatures(VampPluginHandle handle)
     cerr << "PluginAdapterBase::Impl::vampGetRemainingFeatures(" << handle << ")" << endl;
 #endif
 
-    Impl *adapter = lookupAdapter(handle);
-    if (!adapter) return 0;
-    return adapter->getRemainingFeatures((Plugin *)handle);
+    Instance *instance = (Instance *)handle;
+    return instance->adapter->getRemainingFeatures(instance);
 }
 
 void
@@ -635,111 +652,76 @@ PluginAdapterBase::Impl::vampReleaseFeatureSet(VampFeatureList *)
 #endif
 }
 
-void 
-PluginAdapterBase::Impl::cleanup(Plugin *plugin)
+PluginAdapterBase::Impl::Instance::~Instance()
 {
-    // at this point no mutex is held
-    
-    lock_guard<mutex> adapterMapGuard(adapterMapMutex());
-    lock_guard<mutex> guard(m_mutex);
-    
-    if (m_fs.find(plugin) != m_fs.end()) {
-        size_t outputCount = 0;
-        if (m_pluginOutputs[plugin]) {
-            outputCount = m_pluginOutputs[plugin]->size();
-        }
-#ifdef DEBUG_PLUGIN_ADAPTER
-        cerr << "PluginAdapterBase::Impl::cleanup: " << outputCount << " output(s)" << endl;
-#endif
-        VampFeatureList *list = m_fs[plugin];
-        for (unsigned int i = 0; i < outputCount; ++i) {
-            for (unsigned int j = 0; j < m_fsizes[plugin][i]; ++j) {
-                if (list[i].features[j].v1.label) {
-                    free(list[i].features[j].v1.label);
-                }
-                if (list[i].features[j].v1.values) {
-                    free(list[i].features[j].v1.values);
-                }
-            }
-            if (list[i].features) free(list[i].features);
-        }
-        if (list) free((void *)list);
-        m_fs.erase(plugin);
-        m_fsizes.erase(plugin);
-        m_fvsizes.erase(plugin);
-    }
+    free(arena);
 
-    if (m_pluginOutputs.find(plugin) != m_pluginOutputs.end()) {
-        delete m_pluginOutputs[plugin];
-        m_pluginOutputs.erase(plugin);
-    }
+    releaseOutputDescriptors(descriptors);
+    releaseOutputDescriptors(staleDescriptors);
 
-    if (m_adapterMap) {
-        m_adapterMap->erase(plugin);
-
-        if (m_adapterMap->empty()) {
-            delete m_adapterMap;
-            m_adapterMap = 0;
-        }
-    }
-
-    delete ((Plugin *)plugin);
+    delete outputs;
+    delete plugin;
 }
 
 void 
-PluginAdapterBase::Impl::checkOutputMap(Plugin *plugin)
+PluginAdapterBase::Impl::checkOutputMap(Instance *instance)
 {
-    // must be called with m_mutex held
-    
-    OutputMap::iterator i = m_pluginOutputs.find(plugin);
-
-    if (i == m_pluginOutputs.end() || !i->second) {
+    if (!instance->outputs) {
 
-        m_pluginOutputs[plugin] = new Plugin::OutputList
-            (plugin->getOutputDescriptors());
+        instance->outputs = new Plugin::OutputList
+            (instance->plugin->getOutputDescriptors());
 
-//        cerr << "PluginAdapterBase::Impl::checkOutputMap: Have " << m_pluginOutputs[plugin]->size() << " outputs for plugin " << plugin->getIdentifier() << endl;
+//        cerr << "PluginAdapterBase::Impl::checkOutputMap: Have " << instance->outputs->size() << " outputs for plugin " << instance->plugin->getIdentifier() << endl;
     }
 }
 
 void
-PluginAdapterBase::Impl::markOutputsChanged(Plugin *plugin)
+PluginAdapterBase::Impl::markOutputsChanged(Instance *instance)
 {
-    lock_guard<mutex> guard(m_mutex);
-
-    OutputMap::iterator i = m_pluginOutputs.find(plugin);
-
 //    cerr << "PluginAdapterBase::Impl::markOutputsChanged" << endl;
 
-    if (i != m_pluginOutputs.end()) {
+    delete instance->outputs;
+    instance->outputs = 0;
 
-        Plugin::OutputList *list = i->second;
-        m_pluginOutputs.erase(i);
-        delete list;
+    vector<VampOutputDescriptor *> &descs = instance->descriptors;
+    for (size_t i = 0; i < descs.size(); ++i) {
+        if (descs[i]) instance->staleDescriptors.push_back(descs[i]);
     }
+    descs.clear();
 }
 
 unsigned int 
-PluginAdapterBase::Impl::getOutputCount(Plugin *plugin)
+PluginAdapterBase::Impl::getOutputCount(Instance *instance)
 {
-    lock_guard<mutex> guard(m_mutex);
+    checkOutputMap(instance);
 
-    checkOutputMap(plugin);
-
-    return m_pluginOutputs[plugin]->size();
+    return instance->outputs->size();
 }
 
 VampOutputDescriptor *
-PluginAdapterBase::Impl::getOutputDescriptor(Plugin *plugin,
+PluginAdapterBase::Impl::getOutputDescriptor(Instance *instance,
                                              unsigned int i)
 {
-    lock_guard<mutex> guard(m_mutex);
+    releaseOutputDescriptors(instance->staleDescriptors);
+    
+    checkOutputMap(instance);
 
-    checkOutputMap(plugin);
+    if (i >= instance->outputs->size()) return 0;
 
-    Plugin::OutputDescriptor &od =
-        (*m_pluginOutputs[plugin])[i];
+    vector<VampOutputDescriptor *> &descs = instance->descriptors;
+    if (descs.size() < instance->outputs->size()) {
+        descs.resize(instance->outputs->size(), 0);
+    }
+    if (!descs[i]) {
+        descs[i] = convertOutputDescriptor((*instance->outputs)[i]);
+    }
+    
+    return descs[i];
+}
 
+VampOutputDescriptor *
+PluginAdapterBase::Impl::convertOutputDescriptor(const Plugin::OutputDescriptor &od)
+{
     VampOutputDescriptor *desc = (VampOutputDescriptor *)
         malloc(sizeof(VampOutputDescriptor));
 
@@ -792,55 +774,43 @@ PluginAdapterBase::Impl::getOutputDescriptor(Plugin *plugin,
 }
     
 VampFeatureList *
-PluginAdapterBase::Impl::process(Plugin *plugin,
+PluginAdapterBase::Impl::process(Instance *instance,
                                  const float *const *inputBuffers,
                                  int sec, int nsec)
 {
 //    cerr << "PluginAdapterBase::Impl::process" << endl;
 
     RealTime rt(sec, nsec);
-
-    // We don't want to hold the mutex during the actual process call,
-    // only while looking up the associated metadata
-    {    
-        lock_guard<mutex> guard(m_mutex);
-        checkOutputMap(plugin);
-    }
-
-    return convertFeatures(plugin, plugin->process(inputBuffers, rt));
+    checkOutputMap(instance);
+    return convertFeatures(instance, instance->plugin->process(inputBuffers, rt));
 }
     
 VampFeatureList *
-PluginAdapterBase::Impl::getRemainingFeatures(Plugin *plugin)
+PluginAdapterBase::Impl::getRemainingFeatures(Instance *instance)
 {
 //    cerr << "PluginAdapterBase::Impl::getRemainingFeatures" << endl;
 
-    // We don't want to hold the mutex during the actual call, only
-    // while looking up the associated metadata
-    {    
-        lock_guard<mutex> guard(m_mutex);
-        checkOutputMap(plugin);
-    }
-
-    return convertFeatures(plugin, plugin->getRemainingFeatures());
+    checkOutputMap(instance);
+    return convertFeatures(instance, instance->plugin->getRemainingFeatures());
 }
 
 VampFeatureList *
-PluginAdapterBase::Impl::convertFeatures(Plugin *plugin,
+PluginAdapterBase::Impl::convertFeatures(Instance *instance,
                                          const Plugin::FeatureSet &features)
 {
-    lock_guard<mutex> guard(m_mutex);
-
-    int lastN = -1;
-
     int outputCount = 0;
-    if (m_pluginOutputs[plugin]) outputCount = m_pluginOutputs[plugin]->size();
-    
-    resizeFS(plugin, outputCount);
-    VampFeatureList *fs = m_fs[plugin];
+    if (instance->outputs) outputCount = instance->outputs->size();
 
 //    cerr << "PluginAdapter(v2)::convertFeatures: NOTE: sizeof(Feature) == " << sizeof(Plugin::Feature) << ", sizeof(VampFeature) == " << sizeof(VampFeature) << ", sizeof(VampFeatureList) == " << sizeof(VampFeatureList) << endl;
 
+    // Everything we return is carved from the instance's arena: first
+    // the lists, then the features, then their values and labels. We
+    // measure the whole feature set before carving anything, so that
+    // the arena is grown at most once and never moves while in use.
+
+    size_t featureBytes = 0, valueBytes = 0, labelBytes = 0;
+    bool haveFeatures = false;
+
     for (Plugin::FeatureSet::const_iterator fi = features.begin();
          fi != features.end(); ++fi) {
 
@@ -848,67 +818,92 @@ PluginAdapterBase::Impl::convertFeatures(Plugin *plugin,
         
 //        cerr << "PluginAdapterBase::Impl::convertFeatures: n = " << n << endl;
 
-        if (n >= int(outputCount)) {
+        if (n < 0 || n >= outputCount) {
             cerr << "WARNING: PluginAdapterBase::Impl::convertFeatures: Too many outputs from plugin (" << n+1 << ", only should be " << outputCount << ")" << endl;
             continue;
         }
 
-        if (n > lastN + 1) {
-            for (int i = lastN + 1; i < n; ++i) {
-                fs[i].featureCount = 0;
-            }
+        haveFeatures = true;
+
+        const Plugin::FeatureList &fl = fi->second;
+
+        // Each list holds sz v1 features followed by sz v2 ones
+        featureBytes += 2 * fl.size() * sizeof(VampFeatureUnion);
+
+        for (size_t j = 0; j < fl.size(); ++j) {
+            valueBytes += fl[j].values.size() * sizeof(float);
+            if (!fl[j].label.empty()) labelBytes += fl[j].label.size() + 1;
         }
+    }
+
+    if (!haveFeatures) return 0;
+
+    size_t listBytes = alignArena(outputCount * sizeof(VampFeatureList));
+    featureBytes = alignArena(featureBytes);
+    valueBytes = alignArena(valueBytes);
+
+    char *arena = reserveArena
+        (instance, listBytes + featureBytes + valueBytes + labelBytes);
+
+    VampFeatureList *fs = (VampFeatureList *)arena;
+    VampFeatureUnion *fp = (VampFeatureUnion *)(arena + listBytes);
+    float *vp = (float *)(arena + listBytes + featureBytes);
+    char *lp = arena + listBytes + featureBytes + valueBytes;
+
+    for (int i = 0; i < outputCount; ++i) {
+        fs[i].featureCount = 0;
+        fs[i].features = 0;
+    }
+
+    for (Plugin::FeatureSet::const_iterator fi = features.begin();
+         fi != features.end(); ++fi) {
+
+        int n = fi->first;
+        if (n < 0 || n >= outputCount) continue;
 
         const Plugin::FeatureList &fl = fi->second;
 
         size_t sz = fl.size();
-        if (sz > m_fsizes[plugin][n]) resizeFL(plugin, n, sz);
         fs[n].featureCount = sz;
+        fs[n].features = sz ? fp : 0;
         
         for (size_t j = 0; j < sz; ++j) {
 
 //            cerr << "PluginAdapterBase::Impl::convertFeatures: j = " << j << endl;
 
-            VampFeature *feature = &fs[n].features[j].v1;
+            VampFeature *feature = &fp[j].v1;
 
             feature->hasTimestamp = fl[j].hasTimestamp;
             feature->sec = fl[j].timestamp.sec;
             feature->nsec = fl[j].timestamp.nsec;
             feature->valueCount = fl[j].values.size();
 
-            VampFeatureV2 *v2 = &fs[n].features[j + sz].v2;
+            VampFeatureV2 *v2 = &fp[j + sz].v2;
             
             v2->hasDuration = fl[j].hasDuration;
             v2->durationSec = fl[j].duration.sec;
             v2->durationNsec = fl[j].duration.nsec;
 
-            if (feature->label) free(feature->label);
-
             if (fl[j].label.empty()) {
                 feature->label = 0;
             } else {
-                feature->label = strdup(fl[j].label.c_str());
-            }
-
-            if (feature->valueCount > m_fvsizes[plugin][n][j]) {
-                resizeFV(plugin, n, j, feature->valueCount);
+                size_t len = fl[j].label.size() + 1;
+                memcpy(lp, fl[j].label.c_str(), len);
+                feature->label = lp;
+                lp += len;
             }
 
-            for (unsigned int k = 0; k < feature->valueCount; ++k) {
-//                cerr << "PluginAdapterBase::Impl::convertFeatures: k = " << k << endl;
-                feature->values[k] = fl[j].values[k];
+            if (feature->valueCount == 0) {
+                feature->values = 0;
+            } else {
+                memcpy(vp, &fl[j].values[0],
+                       feature->valueCount * sizeof(float));
+                feature->values = vp;
+                vp += feature->valueCount;
             }
         }
 
-        lastN = n;
-    }
-
-    if (lastN == -1) return 0;
-
-    if (int(outputCount) > lastN + 1) {
-        for (int i = lastN + 1; i < int(outputCount); ++i) {
-            fs[i].featureCount = 0;
-        }
+        fp += 2 * sz;
     }
 
 //    cerr << "PluginAdapter(v2)::convertFeatures: NOTE: have " << outputCount << " outputs" << endl;
@@ -916,90 +911,29 @@ PluginAdapterBase::Impl::convertFeatures(Plugin *plugin,
 //        cerr << "PluginAdapter(v2)::convertFeatures: NOTE: output " << i << " has " << fs[i].featureCount << " features" << endl;
 //    }
 
-
     return fs;
 }
 
-void
-PluginAdapterBase::Impl::resizeFS(Plugin *plugin, int n)
+char *
+PluginAdapterBase::Impl::reserveArena(Instance *instance, size_t size)
 {
-    // called with m_mutex held
-    
-#ifdef DEBUG_PLUGIN_ADAPTER
-    cerr << "PluginAdapterBase::Impl::resizeFS(" << plugin << ", " << n << ")" << endl;
-#endif
-
-    int i = m_fsizes[plugin].size();
-    if (i >= n) return;
+    if (instance->arenaSize >= size) return instance->arena;
 
 #ifdef DEBUG_PLUGIN_ADAPTER
-    cerr << "resizing from " << i << endl;
+    cerr << "PluginAdapterBase::Impl::reserveArena(" << instance << ", " << size << "): resizing from " << instance->arenaSize << endl;
 #endif
 
-    m_fs[plugin] = (VampFeatureList *)realloc
-        (m_fs[plugin], n * sizeof(VampFeatureList));
-
-    while (i < n) {
-        m_fs[plugin][i].featureCount = 0;
-        m_fs[plugin][i].features = 0;
-        m_fsizes[plugin].push_back(0);
-        m_fvsizes[plugin].push_back(vector<size_t>());
-        i++;
-    }
-}
-
-void
-PluginAdapterBase::Impl::resizeFL(Plugin *plugin, int n, size_t sz)
-{
-    // called with m_mutex held
+    // The previous contents are never needed again, so there is
+    // nothing to copy. Grow geometrically so that a plugin whose
+    // output varies in size settles down after a few blocks.
     
-#ifdef DEBUG_PLUGIN_ADAPTER
-    cerr << "PluginAdapterBase::Impl::resizeFL(" << plugin << ", " << n << ", "
-              << sz << ")" << endl;
-#endif
-    
-    size_t i = m_fsizes[plugin][n];
-    if (i >= sz) return;
+    if (size < instance->arenaSize * 2) size = instance->arenaSize * 2;
 
-#ifdef DEBUG_PLUGIN_ADAPTER
-    cerr << "resizing from " << i << endl;
-#endif
-
-    m_fs[plugin][n].features = (VampFeatureUnion *)realloc
-        (m_fs[plugin][n].features, 2 * sz * sizeof(VampFeatureUnion));
-
-    while (m_fsizes[plugin][n] < sz) {
-        m_fs[plugin][n].features[m_fsizes[plugin][n]].v1.hasTimestamp = 0;
-        m_fs[plugin][n].features[m_fsizes[plugin][n]].v1.valueCount = 0;
-        m_fs[plugin][n].features[m_fsizes[plugin][n]].v1.values = 0;
-        m_fs[plugin][n].features[m_fsizes[plugin][n]].v1.label = 0;
-        m_fs[plugin][n].features[m_fsizes[plugin][n] + sz].v2.hasDuration = 0;
-        m_fvsizes[plugin][n].push_back(0);
-        m_fsizes[plugin][n]++;
-    }
-}
-
-void
-PluginAdapterBase::Impl::resizeFV(Plugin *plugin, int n, int j, size_t sz)
-{
-    // called with m_mutex held
-    
-#ifdef DEBUG_PLUGIN_ADAPTER
-    cerr << "PluginAdapterBase::Impl::resizeFV(" << plugin << ", " << n << ", "
-              << j << ", " << sz << ")" << endl;
-#endif
-    
-    size_t i = m_fvsizes[plugin][n][j];
-    if (i >= sz) return;
-
-#ifdef DEBUG_PLUGIN_ADAPTER
-    cerr << "resizing from " << i << endl;
-#endif
-    
-    m_fs[plugin][n].features[j].v1.values = (float *)realloc
-        (m_fs[plugin][n].features[j].v1.values, sz * sizeof(float));
+    free(instance->arena);
+    instance->arena = (char *)malloc(size);
+    instance->arenaSize = size;
 
-    m_fvsizes[plugin][n][j] = sz;
+    return instance->arena;
 }
   
 PluginAdapterBase::Impl::AdapterMap *
@@ -28,6 +28,12 @@ static void kf_bfly2(
     vamp_kiss_fft_cpx * Fout2;
     vamp_kiss_fft_cpx * tw1 = st->twiddles;
     vamp_kiss_fft_cpx t;
+#ifdef VAMP_KISS_FFT_SIMD
+    VampKissSIMD::bfly2((vamp_kiss_fft_scalar *)Fout,
+                        (const vamp_kiss_fft_scalar *)st->twiddles,
+                        fstride, m);
+    return;
+#endif
     Fout2 = Fout + m;
     do{
         C_FIXDIV(*Fout,2); C_FIXDIV(*Fout2,2);
@@ -54,6 +60,12 @@ static void kf_bfly4(
     const size_t m2=2*m;
     const size_t m3=3*m;
 
+#ifdef VAMP_KISS_FFT_SIMD
+    VampKissSIMD::bfly4((vamp_kiss_fft_scalar *)Fout,
+                        (const vamp_kiss_fft_scalar *)st->twiddles,
+                        fstride, m, st->inverse != 0);
+    return;
+#endif
 
     tw3 = tw2 = tw1 = st->twiddles;
 
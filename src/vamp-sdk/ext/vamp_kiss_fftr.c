@@ -100,6 +100,14 @@ void vamp_kiss_fftr(vamp_kiss_fftr_cfg st,const vamp_kiss_fft_scalar *timedata,v
     freqdata[ncfft].r = tdc.r - tdc.i;
     freqdata[ncfft].i = freqdata[0].i = 0;
 
+#ifdef VAMP_KISS_FFT_SIMD
+    VampKissSIMD::realPostTwiddle((vamp_kiss_fft_scalar *)freqdata,
+                                  (const vamp_kiss_fft_scalar *)st->tmpbuf,
+                                  (const vamp_kiss_fft_scalar *)st->super_twiddles,
+                                  ncfft);
+    return;
+#endif
+
     for ( k=1;k <= ncfft/2 ; ++k ) {
         fpk    = st->tmpbuf[k]; 
         fpnk.r =   st->tmpbuf[ncfft-k].r;
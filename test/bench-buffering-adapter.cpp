@@ -0,0 +1,173 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Vamp
+
+    An API for audio analysis and feature extraction plugins.
+
+    Centre for Digital Music, Queen Mary, University of London.
+    Copyright 2006-2020 Chris Cannam and QMUL.
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and Chris Cannam
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+/*
+ * Measure the throughput of PluginBufferingAdapter at a range of host
+ * block sizes. The adapter wraps a plugin that does nothing with its
+ * input, so the time measured is that of the adapter itself: copying
+ * the host's blocks into its ring buffers and the plugin's blocks out
+ * of them, and calling the plugin. The plugin takes two channels,
+ * with block size 1024 and step size 512, so that each frame passes
+ * through the ring buffers twice.
+ *
+ * For each host block size from 64 to 65536 frames, the adapter is
+ * fed a stream in blocks of that size and the time per frame (per
+ * channel) reported.
+ *
+ * Usage: bench-buffering-adapter [frames]
+ *
+ * where frames is the length of the stream for each block size
+ * (default 16777216).
+ */
+
+#include <vamp-hostsdk/PluginBufferingAdapter.h>
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <chrono>
+
+using namespace std;
+
+using Vamp::Plugin;
+using Vamp::RealTime;
+using Vamp::HostExt::PluginBufferingAdapter;
+
+static const float rate = 44100.f;
+
+class NullPlugin : public Plugin
+{
+public:
+    NullPlugin() : Plugin(rate) { }
+
+    string getIdentifier() const { return "null"; }
+    string getName() const { return "Null"; }
+    string getDescription() const { return ""; }
+    string getMaker() const { return ""; }
+    string getCopyright() const { return ""; }
+    int getPluginVersion() const { return 1; }
+
+    InputDomain getInputDomain() const { return TimeDomain; }
+    size_t getPreferredBlockSize() const { return 1024; }
+    size_t getPreferredStepSize() const { return 512; }
+    size_t getMinChannelCount() const { return 2; }
+    size_t getMaxChannelCount() const { return 2; }
+
+    bool initialise(size_t, size_t, size_t) { return true; }
+    void reset() { }
+
+    OutputList getOutputDescriptors() const {
+        OutputDescriptor d;
+        d.identifier = "null";
+        d.name = "Null";
+        d.hasFixedBinCount = true;
+        d.binCount = 0;
+        d.sampleType = OutputDescriptor::OneSamplePerStep;
+        OutputList list;
+        list.push_back(d);
+        return list;
+    }
+
+    FeatureSet process(const float *const *, RealTime) {
+        return FeatureSet();
+    }
+
+    FeatureSet getRemainingFeatures() { return FeatureSet(); }
+};
+
+static double
+run(size_t hostBlockSize, size_t frames)
+{
+    PluginBufferingAdapter adapter(new NullPlugin());
+
+    if (!adapter.initialise(2, hostBlockSize, hostBlockSize)) {
+        cerr << "initialise failed for host block size "
+             << hostBlockSize << endl;
+        return 0.0;
+    }
+
+    vector<float> left(hostBlockSize), right(hostBlockSize);
+    for (size_t i = 0; i < hostBlockSize; ++i) {
+        left[i] = sinf(float(i) * 0.01f);
+        right[i] = cosf(float(i) * 0.01f);
+    }
+    const float *input[2] = { &left[0], &right[0] };
+
+    size_t blocks = frames / hostBlockSize;
+    if (blocks == 0) blocks = 1;
+
+    // The first tenth of the stream warms up the adapter's buffers
+    // and is not measured
+    size_t warmup = blocks / 10;
+
+    chrono::steady_clock::time_point start;
+
+    for (size_t i = 0; i < warmup + blocks; ++i) {
+        if (i == warmup) {
+            start = chrono::steady_clock::now();
+        }
+        RealTime t = RealTime::frame2RealTime
+            (long(i * hostBlockSize), int(rate));
+        adapter.process(input, t);
+    }
+
+    double ns = chrono::duration<double, nano>
+        (chrono::steady_clock::now() - start).count();
+
+    return ns / double(blocks * hostBlockSize);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 2) {
+        cerr << "Usage: " << argv[0] << " [frames]" << endl;
+        return 2;
+    }
+
+    size_t frames = (argc > 1 ? size_t(atol(argv[1])) : (size_t(1) << 24));
+    if (frames == 0) frames = size_t(1) << 24;
+
+    printf("%-12s %s\n", "host block", "ns/frame");
+
+    for (size_t hostBlockSize = 64; hostBlockSize <= 65536;
+         hostBlockSize *= 4) {
+        printf("%-12zu %.2f\n", hostBlockSize, run(hostBlockSize, frames));
+    }
+
+    return 0;
+}
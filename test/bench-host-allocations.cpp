@@ -0,0 +1,229 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Vamp
+
+    An API for audio analysis and feature extraction plugins.
+
+    Centre for Digital Music, Queen Mary, University of London.
+    Copyright 2006-2020 Chris Cannam and QMUL.
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and Chris Cannam
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+/*
+ * Count the memory allocations made per process call when running
+ * each plugin in a plugin library through PluginHostAdapter, and time
+ * the calls. Each plugin is run three ways:
+ *
+ *  - through the plugin's C API only, giving the allocations made by
+ *    the plugin side of the SDK (and the plugin itself);
+ *
+ *  - through PluginHostAdapter::process(), which converts the
+ *    features into a new FeatureSet on each call;
+ *
+ *  - through PluginHostAdapter::processInto(), which converts them
+ *    into a FeatureBuffer reused from one call to the next.
+ *
+ * The difference between the first figure and the others is the cost
+ * of the host side. Allocations are counted by replacing the global
+ * operator new, so only C++ allocations are seen.
+ *
+ * Usage: bench-host-allocations pluginlibrary [blocksize]
+ */
+
+#include <vamp-hostsdk/PluginHostAdapter.h>
+#include <vamp-hostsdk/PluginWrapper.h>
+
+#include "../host/system.h"
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <chrono>
+#include <new>
+
+using namespace std;
+
+using Vamp::Plugin;
+using Vamp::PluginHostAdapter;
+using Vamp::RealTime;
+using Vamp::HostExt::FeatureBuffer;
+
+static long allocations = 0;
+
+void *operator new(size_t n)
+{
+    ++allocations;
+    void *p = malloc(n ? n : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+enum Mode { CAPIOnly, Process, ProcessInto };
+
+static const char *modeNames[] = { "C API only", "process()", "processInto()" };
+
+static void
+run(const VampPluginDescriptor *descriptor, Mode mode, int maxBlockSize)
+{
+    const float rate = 44100.f;
+    const int calls = 400;
+
+    PluginHostAdapter adapter(descriptor, rate);
+
+    size_t step = adapter.getPreferredStepSize();
+    size_t block = adapter.getPreferredBlockSize();
+    if (block == 0) block = maxBlockSize;
+    if (step == 0) step = block;
+    if (block > size_t(maxBlockSize)) {
+        block = maxBlockSize;
+        step = block / 2;
+    }
+
+    VampPluginHandle handle = 0;
+    if (mode == CAPIOnly) {
+        handle = descriptor->instantiate(descriptor, rate);
+        if (!handle || !descriptor->initialise(handle, 1, step, block)) {
+            cerr << descriptor->identifier << ": initialise failed" << endl;
+            if (handle) descriptor->cleanup(handle);
+            return;
+        }
+    } else if (!adapter.initialise(1, step, block)) {
+        cerr << descriptor->identifier << ": initialise failed" << endl;
+        return;
+    }
+
+    // Frequency-domain plugins take block + 2 values; a decaying
+    // sinusoid with periodic bursts gives the example plugins some
+    // features to return
+    vector<float> buffer(block + 2);
+    for (size_t i = 0; i < block; ++i) {
+        buffer[i] = sinf(float(i) * 0.05f) * (i % 300 < 10 ? 1.f : 0.1f);
+    }
+    const float *input = &buffer[0];
+
+    FeatureBuffer features;
+    long before = 0, featureCount = 0;
+    chrono::steady_clock::time_point start;
+
+    // The first half of the calls warms up the host and plugin
+    // storage; only the second half is measured
+
+    for (int i = 0; i < calls * 2; ++i) {
+
+        if (i == calls) {
+            before = allocations;
+            start = chrono::steady_clock::now();
+        }
+
+        RealTime t = RealTime::frame2RealTime(long(i * step), int(rate));
+
+        if (mode == CAPIOnly) {
+            VampFeatureList *fl = descriptor->process
+                (handle, &input, t.sec, t.nsec);
+            if (fl) {
+                unsigned int outputs = descriptor->getOutputCount(handle);
+                for (unsigned int o = 0; o < outputs; ++o) {
+                    featureCount += fl[o].featureCount;
+                }
+                descriptor->releaseFeatureSet(fl);
+            }
+        } else if (mode == Process) {
+            Plugin::FeatureSet fs = adapter.process(&input, t);
+            for (Plugin::FeatureSet::const_iterator j = fs.begin();
+                 j != fs.end(); ++j) {
+                featureCount += long(j->second.size());
+            }
+        } else {
+            adapter.processInto(&input, t, features);
+            for (int o = 0; o < features.getOutputCount(); ++o) {
+                featureCount += long(features.getFeatureCount(o));
+            }
+        }
+    }
+
+    double us = chrono::duration<double, micro>
+        (chrono::steady_clock::now() - start).count() / calls;
+    long allocated = allocations - before;
+
+    if (handle) descriptor->cleanup(handle);
+
+    printf("%-22s %-14s %7.2f allocs/call %8.2f us/call (%ld features)\n",
+           descriptor->identifier, modeNames[mode],
+           double(allocated) / calls, us, featureCount);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 3) {
+        cerr << "Usage: " << argv[0] << " pluginlibrary." << PLUGIN_SUFFIX
+             << " [blocksize]" << endl;
+        return 2;
+    }
+
+    string libraryPath = argv[1];
+    int maxBlockSize = (argc > 2 ? atoi(argv[2]) : 1024);
+    if (maxBlockSize < 2) maxBlockSize = 1024;
+
+    void *library = DLOPEN(libraryPath, RTLD_LAZY | RTLD_LOCAL);
+    if (!library) {
+        cerr << argv[0] << ": Failed to open library " << libraryPath
+             << ": " << DLERROR() << endl;
+        return 1;
+    }
+
+    VampGetPluginDescriptorFunction fn = (VampGetPluginDescriptorFunction)
+        DLSYM(library, "vampGetPluginDescriptor");
+    if (!fn) {
+        cerr << argv[0] << ": No Vamp descriptor function in library "
+             << libraryPath << endl;
+        DLCLOSE(library);
+        return 1;
+    }
+
+    const VampPluginDescriptor *descriptor = 0;
+    for (int index = 0; (descriptor = fn(VAMP_API_VERSION, index)); ++index) {
+        run(descriptor, CAPIOnly, maxBlockSize);
+        run(descriptor, Process, maxBlockSize);
+        run(descriptor, ProcessInto, maxBlockSize);
+    }
+
+    DLCLOSE(library);
+    return 0;
+}
@@ -2,6 +2,20 @@
 
 set -eu
 
+# Runs vamp-test-plugin (expected in ../../vamp-test-plugin) through
+# vamp-simple-host over testsignal.wav, and compares each output with
+# the file of the same name in expected/.
+#
+# NOTE: The vamp-test-plugin-freq_*.txt files in expected/ were made
+# when PluginInputDomainAdapter windowed and transformed in double
+# precision. It now does so in single precision, which changes
+# printed spectral values in the sixth significant figure. Those
+# files have not been regenerated since, so the frequency-domain
+# outputs that print spectral values (such as input-summary) are
+# likely to fail here. After checking that any differences in
+# failures/ are only of that order, copy the obtained files over the
+# expected ones.
+
 MYDIR=$(dirname "$0")
 
 TEST_PLUGIN_DIR="$MYDIR/../../vamp-test-plugin"
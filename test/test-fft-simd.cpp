@@ -0,0 +1,190 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Vamp
+
+    An API for audio analysis and feature extraction plugins.
+
+    Centre for Digital Music, Queen Mary, University of London.
+    Copyright 2006-2020 Chris Cannam and QMUL.
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and Chris Cannam
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+/*
+ * Test that the vectorised KissFFT kernels in FFTsimd.h give the same
+ * results as the scalar code they replace.
+ *
+ * The SDK's FFT code is built three times into this program: with
+ * NO_SIMD_FFT (test-fft-simd-scalar.cpp), with NO_AVX_FFT so that
+ * only the SSE2 kernels are used (test-fft-simd-sse2.cpp), and with
+ * the default settings (this file), which use AVX if the CPU has
+ * it. Every transform in the FFT, FFTComplex, FFTReal,
+ * FFTComplexFloat and FFTRealFloat classes is run over the same
+ * input at power-of-two sizes from 2 to 8192 and at even sizes with
+ * odd factors, and the vectorised builds' output compared with that
+ * of the scalar build.
+ *
+ * The kernels perform the same operations in the same order as the
+ * scalar code, and should match it exactly. A small tolerance is
+ * allowed all the same, since the compiler is free to contract the
+ * scalar code's multiplies and adds into fused ones on targets that
+ * have them.
+ *
+ * The kernels are only used in optimised builds, so this program
+ * must be compiled with optimisation. It exits with status 77
+ * (skipped) if no vectorised kernels were compiled in. On aarch64,
+ * build it with VAMP_KISS_FFT_NEON defined to test the NEON kernels.
+ *
+ * Usage: test-fft-simd
+ */
+
+#include "../src/vamp-sdk/FFT.cpp"
+
+#include "test-fft-simd.h"
+
+#include <iostream>
+#include <string>
+#include <cmath>
+
+using namespace std;
+
+const char *
+nativeKernels()
+{
+    return kernelsInUse();
+}
+
+void
+nativeTransforms(int n, const vector<double> &input, TransformOutput &out)
+{
+    runTransforms(n, input, out);
+}
+
+static int failures = 0;
+
+template <typename T>
+static void
+compare(const vector<T> &expected, const vector<T> &actual,
+        double tolerance, string what)
+{
+    if (actual.size() != expected.size()) {
+        cerr << "FAIL: " << what << ": " << actual.size()
+             << " values, expected " << expected.size() << endl;
+        ++failures;
+        return;
+    }
+
+    // Relative to the largest output value, as the transforms'
+    // rounding errors scale with that rather than with each value
+    double scale = 1.0;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        scale = max(scale, fabs(double(expected[i])));
+    }
+
+    double worst = 0.0;
+    size_t worstAt = 0;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        double diff = fabs(double(actual[i]) - double(expected[i]));
+        if (!(diff <= worst)) {
+            worst = diff;
+            worstAt = i;
+        }
+    }
+
+    if (!(worst <= tolerance * scale)) {
+        cerr << "FAIL: " << what << ": value " << worstAt << " is "
+             << actual[worstAt] << ", expected " << expected[worstAt]
+             << endl;
+        ++failures;
+    }
+}
+
+int main(int argc, char **)
+{
+    if (argc != 1) {
+        cerr << "Usage: test-fft-simd" << endl;
+        return 2;
+    }
+
+    cerr << "test-fft-simd: comparing " << sse2Kernels() << " and "
+         << nativeKernels() << " kernels with " << scalarKernels()
+         << " code" << endl;
+
+    if (string(sse2Kernels()) == "scalar" &&
+        string(nativeKernels()) == "scalar") {
+        cerr << "test-fft-simd: no vectorised kernels compiled in "
+             << "(unoptimised build, or unsupported platform)" << endl;
+        return 77;
+    }
+
+    vector<int> sizes;
+    for (int n = 2; n <= 8192; n *= 2) {
+        sizes.push_back(n);
+    }
+    const int others[] = {
+        6, 10, 12, 14, 18, 20, 24, 30, 36, 40, 48, 50, 60, 72, 80,
+        96, 100, 120, 144, 160, 192, 200, 250, 300, 384, 500, 640, 768,
+        1000, 1536
+    };
+    for (size_t i = 0; i < sizeof(others) / sizeof(others[0]); ++i) {
+        sizes.push_back(others[i]);
+    }
+
+    for (size_t i = 0; i < sizes.size(); ++i) {
+
+        int n = sizes[i];
+
+        // A fixed pseudo-random input, the same for every build
+        vector<double> input(2 * n + 2);
+        unsigned int seed = 1234567u + n;
+        for (size_t j = 0; j < input.size(); ++j) {
+            seed = seed * 1664525u + 1013904223u;
+            input[j] = double(seed >> 8) / double(1 << 23) - 1.0;
+        }
+
+        TransformOutput scalar, sse2, native;
+        scalarTransforms(n, input, scalar);
+        sse2Transforms(n, input, sse2);
+        nativeTransforms(n, input, native);
+
+        string size = to_string(n);
+        compare(scalar.d, sse2.d, 1e-13, string(sse2Kernels()) +
+                " double, size " + size);
+        compare(scalar.f, sse2.f, 1e-5, string(sse2Kernels()) +
+                " float, size " + size);
+        compare(scalar.d, native.d, 1e-13, string(nativeKernels()) +
+                " double, size " + size);
+        compare(scalar.f, native.f, 1e-5, string(nativeKernels()) +
+                " float, size " + size);
+    }
+
+    if (failures > 0) {
+        cerr << failures << " check(s) failed" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Vamp
+
+    An API for audio analysis and feature extraction plugins.
+
+    Centre for Digital Music, Queen Mary, University of London.
+    Copyright 2006-2020 Chris Cannam and QMUL.
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and Chris Cannam
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+/*
+ * Shared by the test-fft-simd translation units. Each of them builds
+ * the SDK's FFT code, by including FFT.cpp, with different SIMD
+ * settings and into a different SDK namespace, and then includes
+ * this header to get the functions that run its transforms.
+ */
+
+#ifndef _VAMP_TEST_FFT_SIMD_H_
+#define _VAMP_TEST_FFT_SIMD_H_
+
+#include <vector>
+
+/**
+ * The output of every transform the SDK offers at one size, with the
+ * double- and single-precision results kept apart as they are
+ * compared with different tolerances.
+ */
+struct TransformOutput {
+    std::vector<double> d;
+    std::vector<float> f;
+};
+
+// Scalar code only: built with NO_SIMD_FFT, in namespace _VampHost
+const char *scalarKernels();
+void scalarTransforms(int n, const std::vector<double> &input,
+                      TransformOutput &out);
+
+// SSE2 only: built with NO_AVX_FFT, in no plugin namespace
+const char *sse2Kernels();
+void sse2Transforms(int n, const std::vector<double> &input,
+                    TransformOutput &out);
+
+// Whatever the platform and CPU support: built with the default
+// settings, in namespace _VampPlugin
+const char *nativeKernels();
+void nativeTransforms(int n, const std::vector<double> &input,
+                      TransformOutput &out);
+
+#endif
+
+#ifdef _VAMP_FFT_SIMD_H_
+#ifndef _VAMP_TEST_FFT_SIMD_IMPL_
+#define _VAMP_TEST_FFT_SIMD_IMPL_
+
+// The rest is only for translation units that have included FFT.cpp
+
+static const char *
+kernelsInUse()
+{
+#ifdef VAMP_KISS_SIMD_AVX
+    if (VampKissSIMD::haveAVX()) return "AVX";
+#endif
+#if defined(VAMP_KISS_SIMD_SSE2)
+    return "SSE2";
+#elif defined(VAMP_KISS_SIMD_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+template <typename T>
+static void
+append(std::vector<T> &out, const std::vector<T> &v, int count)
+{
+    out.insert(out.end(), v.begin(), v.begin() + count);
+}
+
+static void
+runTransforms(int n, const std::vector<double> &input, TransformOutput &out)
+{
+    // input holds at least 2n + 2 values, used as real or as
+    // interleaved complex data as each transform requires
+
+    out.d.clear();
+    out.f.clear();
+
+    const double *in = &input[0];
+    std::vector<double> re(n), im(n), buf(4 * n + 4);
+
+    Vamp::FFT::forward(n, in, in + n, &re[0], &im[0]);
+    append(out.d, re, n);
+    append(out.d, im, n);
+
+    Vamp::FFT::forward(n, in, 0, &re[0], &im[0]);
+    append(out.d, re, n);
+    append(out.d, im, n);
+
+    if ((n & (n - 1)) == 0) {
+        Vamp::FFT::inverse(n, in, in + n, &re[0], &im[0]);
+        append(out.d, re, n);
+        append(out.d, im, n);
+    }
+
+    Vamp::FFTComplex complex(n);
+    complex.forward(in, &buf[0]);
+    append(out.d, buf, 2 * n);
+    complex.inverse(in, &buf[0]);
+    append(out.d, buf, 2 * n);
+
+    Vamp::FFTReal real(n);
+    real.forward(in, &buf[0]);
+    append(out.d, buf, n + 2);
+    real.inverse(in, &buf[0]);
+    append(out.d, buf, n);
+
+    // Two overlapping frames, half a frame apart
+    real.forwardBatch(in, n / 2, &buf[0], n + 2, 2);
+    append(out.d, buf, 2 * n + 4);
+
+    std::vector<float> fin(input.begin(), input.end()), fbuf(4 * n + 4);
+    const float *fi = &fin[0];
+
+    Vamp::FFTComplexFloat complexFloat(n);
+    complexFloat.forward(fi, &fbuf[0]);
+    append(out.f, fbuf, 2 * n);
+    complexFloat.inverse(fi, &fbuf[0]);
+    append(out.f, fbuf, 2 * n);
+
+    Vamp::FFTRealFloat realFloat(n);
+    realFloat.forward(fi, &fbuf[0]);
+    append(out.f, fbuf, n + 2);
+    realFloat.inverse(fi, &fbuf[0]);
+    append(out.f, fbuf, n);
+
+    realFloat.forwardBatch(fi, n / 2, &fbuf[0], n + 2, 2);
+    append(out.f, fbuf, 2 * n + 4);
+}
+
+#endif
+#endif
@@ -0,0 +1,384 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Vamp
+
+    An API for audio analysis and feature extraction plugins.
+
+    Centre for Digital Music, Queen Mary, University of London.
+    Copyright 2006-2020 Chris Cannam and QMUL.
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and Chris Cannam
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+/*
+ * Test the plugin library cache written by PluginLoader.
+ *
+ * PluginLoader is a singleton that reads its cache once, so each
+ * listing is made by running this program again as a child process,
+ * with VAMP_PATH pointing at a private copy of a plugin library and
+ * XDG_CACHE_HOME at an empty directory. The test checks that:
+ *
+ *  - no cache is written unless the host enables it;
+ *
+ *  - VAMP_PLUGIN_CACHE enables the cache using the file it names;
+ *
+ *  - the cache directory is created and the cache written, with the
+ *    library's size and plugin identifiers;
+ *
+ *  - a later listing takes its identifiers from the cache rather than
+ *    from the library, while the library's size and modification
+ *    time are unchanged;
+ *
+ *  - a change of modification time invalidates the library's entry;
+ *
+ *  - entries for libraries that no longer exist are dropped, while
+ *    those for libraries merely not on the path are kept;
+ *
+ *  - a truncated or damaged cache file is ignored and rewritten.
+ *
+ * Usage: test-plugin-cache vamp-example-plugins.so
+ *
+ * The test uses POSIX facilities to manage its child processes and
+ * files, and is skipped on Windows.
+ */
+
+#ifdef _WIN32
+
+#include <iostream>
+
+int main()
+{
+    std::cerr << "test-plugin-cache: not supported on this platform" << std::endl;
+    return 77;
+}
+
+#else
+
+#include <vamp-hostsdk/PluginLoader.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+using namespace std;
+
+using Vamp::HostExt::PluginLoader;
+
+static int failures = 0;
+
+static void
+check(bool condition, string what)
+{
+    if (!condition) {
+        cerr << "FAIL: " << what << endl;
+        ++failures;
+    }
+}
+
+static string
+readFile(string path)
+{
+    ifstream is(path.c_str(), ifstream::in | ifstream::binary);
+    ostringstream contents;
+    contents << is.rdbuf();
+    return contents.str();
+}
+
+static void
+writeFile(string path, string contents)
+{
+    ofstream os(path.c_str(), ofstream::out | ofstream::binary |
+                ofstream::trunc);
+    os << contents;
+}
+
+static bool
+copyFile(string from, string to)
+{
+    ifstream is(from.c_str(), ifstream::in | ifstream::binary);
+    ofstream os(to.c_str(), ofstream::out | ofstream::binary |
+                ofstream::trunc);
+    os << is.rdbuf();
+    return !is.fail() && !os.fail();
+}
+
+static bool
+replaceAll(string &s, string from, string to)
+{
+    bool found = false;
+    string::size_type i = 0;
+    while ((i = s.find(from, i)) != string::npos) {
+        s.replace(i, from.length(), to);
+        i += to.length();
+        found = true;
+    }
+    return found;
+}
+
+static bool
+fileExists(string path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0;
+}
+
+static string
+runChild(string self, string mode = "--list-cached")
+{
+    // Return the plugin keys listed by a child process, one per line
+    string output;
+    FILE *f = popen((self + " " + mode).c_str(), "r");
+    if (!f) return output;
+    char buffer[1024];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        output.append(buffer, n);
+    }
+    pclose(f);
+    return output;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 2 && (string(argv[1]) == "--list" ||
+                      string(argv[1]) == "--list-cached")) {
+        PluginLoader *loader = PluginLoader::getInstance();
+        if (string(argv[1]) == "--list-cached") {
+            loader->setLibraryCacheEnabled(true);
+        }
+        PluginLoader::PluginKeyList keys = loader->listPlugins();
+        for (size_t i = 0; i < keys.size(); ++i) {
+            cout << keys[i] << endl;
+        }
+        return 0;
+    }
+
+    if (argc != 2) {
+        cerr << "Usage: " << argv[0] << " pluginlibrary" << endl;
+        return 2;
+    }
+
+    char dirTemplate[] = "/tmp/vamp-cache-test-XXXXXX";
+    if (!mkdtemp(dirTemplate)) {
+        cerr << "Failed to create temporary directory" << endl;
+        return 1;
+    }
+    string dir = dirTemplate;
+    string pluginDir = dir + "/plugins";
+    string cacheHome = dir + "/cache";
+    string library = pluginDir + "/vamp-example-plugins.so";
+
+    ostringstream cacheName;
+    cacheName << cacheHome << "/vamp/vamp-plugin-cache-"
+              << (sizeof(void *) * 8) << ".txt";
+    string cachePath = cacheName.str();
+
+    mkdir(pluginDir.c_str(), 0700);
+    if (!copyFile(argv[1], library)) {
+        cerr << "Failed to copy plugin library " << argv[1] << endl;
+        return 1;
+    }
+
+    // The cache home does not exist yet, as with a fresh home
+    // directory; the loader must create it and its vamp subdirectory
+    setenv("VAMP_PATH", pluginDir.c_str(), 1);
+    setenv("XDG_CACHE_HOME", cacheHome.c_str(), 1);
+    unsetenv("VAMP_PLUGIN_CACHE");
+
+    string self = argv[0];
+
+    // 0. By default the cache is disabled: nothing is written, and
+    // the cache home is not even created
+
+    string listed = runChild(self, "--list");
+    check(listed.find("vamp-example-plugins:zerocrossing\n") != string::npos,
+          "listing without cache finds plugins");
+    check(!fileExists(cacheHome),
+          "no cache written by default");
+
+    // VAMP_PLUGIN_CACHE enables it, using the file it names
+
+    string envCachePath = dir + "/env-cache.txt";
+    setenv("VAMP_PLUGIN_CACHE", envCachePath.c_str(), 1);
+    listed = runChild(self, "--list");
+    unsetenv("VAMP_PLUGIN_CACHE");
+    check(listed.find("vamp-example-plugins:zerocrossing\n") != string::npos,
+          "listing with VAMP_PLUGIN_CACHE finds plugins");
+    check(readFile(envCachePath).find("\nzerocrossing\n") != string::npos,
+          "VAMP_PLUGIN_CACHE file written");
+    check(!fileExists(cacheHome),
+          "VAMP_PLUGIN_CACHE file used instead of default");
+    remove(envCachePath.c_str());
+
+    // 1. First listing with the cache enabled writes it, with the
+    // library's stamp
+
+    listed = runChild(self);
+    check(listed.find("vamp-example-plugins:zerocrossing\n") != string::npos,
+          "first listing finds plugins");
+
+    string cache = readFile(cachePath);
+    check(cache.find("Vamp plugin library cache v1\n") == 0,
+          "cache written with header");
+    check(cache.size() >= 4 && cache.substr(cache.size() - 4) == "end\n",
+          "cache written with end marker");
+    check(cache.find(" " + library + "\n") != string::npos,
+          "cache records library path");
+    check(cache.find("\nzerocrossing\n") != string::npos,
+          "cache records plugin identifiers");
+
+    struct stat st;
+    stat(library.c_str(), &st);
+    ostringstream sizeField;
+    sizeField << "\n" << st.st_size << " ";
+    check(cache.find(sizeField.str()) != string::npos,
+          "cache records library size");
+
+    // 2. With the stamp unchanged, identifiers come from the cache.
+    // Editing one in the cache file, without touching the library,
+    // makes it appear in the listing
+
+    string edited = cache;
+    check(replaceAll(edited, "\nzerocrossing\n", "\ncachedcrossing\n"),
+          "identifier found to edit");
+    writeFile(cachePath, edited);
+
+    listed = runChild(self);
+    check(listed.find("vamp-example-plugins:cachedcrossing\n") != string::npos,
+          "unchanged library listed from cache");
+    check(listed.find("vamp-example-plugins:zerocrossing\n") == string::npos,
+          "unchanged library not rescanned");
+
+    // 3. A new modification time invalidates the entry, so the
+    // library is scanned again and the cache rewritten
+
+    struct timeval times[2];
+    times[0].tv_sec = times[1].tv_sec = st.st_mtime + 100;
+    times[0].tv_usec = times[1].tv_usec = 0;
+    utimes(library.c_str(), times);
+
+    listed = runChild(self);
+    check(listed.find("vamp-example-plugins:zerocrossing\n") != string::npos,
+          "modified library rescanned");
+    check(listed.find("vamp-example-plugins:cachedcrossing\n") == string::npos,
+          "stale cache entry discarded");
+    cache = readFile(cachePath);
+    check(cache.find("\ncachedcrossing\n") == string::npos &&
+          cache.find("\nzerocrossing\n") != string::npos,
+          "cache rewritten after modification");
+
+    // 4. Entries for libraries that no longer exist are dropped when
+    // all plugins are listed, but those for libraries that exist
+    // elsewhere than on this process's path are kept, because
+    // another process with a different path may share the cache
+
+    string elsewhere = dir + "/elsewhere.so";
+    string missing = dir + "/missing.so";
+    writeFile(elsewhere, "not really a library");
+
+    edited = cache;
+    edited = edited.substr(0, edited.size() - 4);
+    edited += "1 1 1 " + elsewhere + "\nelsewhereplugin\n";
+    edited += "1 1 1 " + missing + "\nmissingplugin\n";
+    edited += "end\n";
+    writeFile(cachePath, edited);
+
+    listed = runChild(self);
+    check(listed.find("vamp-example-plugins:zerocrossing\n") != string::npos &&
+          listed.find("elsewhereplugin") == string::npos,
+          "libraries off the path not listed");
+    cache = readFile(cachePath);
+    check(cache.find(" " + missing + "\n") == string::npos,
+          "missing library dropped from cache");
+    check(cache.find(" " + elsewhere + "\nelsewhereplugin\n") != string::npos,
+          "library off the path kept in cache");
+
+    remove(elsewhere.c_str());
+
+    // 5. A cache without its end marker, as if truncated while being
+    // written, is ignored even though its entries are plausible
+
+    edited = cache;
+    replaceAll(edited, "\nzerocrossing\n", "\ncachedcrossing\n");
+    edited = edited.substr(0, edited.size() - 4);
+    writeFile(cachePath, edited);
+
+    listed = runChild(self);
+    check(listed.find("vamp-example-plugins:zerocrossing\n") != string::npos &&
+          listed.find("vamp-example-plugins:cachedcrossing\n") == string::npos,
+          "truncated cache ignored");
+    cache = readFile(cachePath);
+    check(cache.size() >= 4 && cache.substr(cache.size() - 4) == "end\n",
+          "truncated cache rewritten");
+
+    // 6. So is one whose records cannot be parsed, or that is not a
+    // cache file at all
+
+    edited = cache;
+    replaceAll(edited, sizeField.str(), "\nnonsense ");
+    writeFile(cachePath, edited);
+
+    listed = runChild(self);
+    check(listed.find("vamp-example-plugins:zerocrossing\n") != string::npos,
+          "damaged cache ignored");
+    cache = readFile(cachePath);
+    check(cache.find("nonsense") == string::npos &&
+          cache.find(sizeField.str()) != string::npos,
+          "damaged cache rewritten");
+
+    writeFile(cachePath, "\x7f" "ELF garbage\nend\n");
+
+    listed = runChild(self);
+    check(listed.find("vamp-example-plugins:zerocrossing\n") != string::npos,
+          "foreign file ignored");
+    cache = readFile(cachePath);
+    check(cache.find("Vamp plugin library cache v1\n") == 0,
+          "foreign file replaced");
+
+    remove(cachePath.c_str());
+    rmdir((cacheHome + "/vamp").c_str());
+    rmdir(cacheHome.c_str());
+    remove(library.c_str());
+    rmdir(pluginDir.c_str());
+    rmdir(dir.c_str());
+
+    if (failures > 0) {
+        cerr << failures << " check(s) failed" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,198 @@
+/* -*- c-basic-offset: 4 indent-tabs-mode: nil -*-  vi:set ts=8 sts=4 sw=4: */
+
+/*
+    Vamp
+
+    An API for audio analysis and feature extraction plugins.
+
+    Centre for Digital Music, Queen Mary, University of London.
+    Copyright 2006-2020 Chris Cannam and QMUL.
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR
+    ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+    CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+    WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+    Except as contained in this notice, the names of the Centre for
+    Digital Music; Queen Mary, University of London; and Chris Cannam
+    shall not be used in advertising or otherwise to promote the sale,
+    use or other dealings in this Software without prior written
+    authorization.
+*/
+
+/*
+ * Test that PluginInputDomainAdapters sharing a SpectralSource give
+ * the same features as they would without it, when the plugins
+ * loaded with it receive different audio after channel adaptation.
+ *
+ * Two copies of the power spectrum example plugin, which takes one
+ * channel, are loaded with all adapters and the same source, and fed
+ * the same stereo stream with a different sinusoid in each channel.
+ * Their channel adapters mix down with different gains, picking out
+ * the left channel for one plugin and the right for the other, so
+ * their input-domain adapters see different audio at the same
+ * timestamps and must not share spectra. A third copy uses the same
+ * gains as the first, and a fourth the default mean mixdown. Each is
+ * compared with a copy run on its own without a source.
+ *
+ * Usage: test-spectral-source vamp-example-plugins.so
+ */
+
+#include <vamp-hostsdk/PluginLoader.h>
+#include <vamp-hostsdk/PluginInputDomainAdapter.h>
+#include <vamp-hostsdk/PluginChannelAdapter.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+
+using Vamp::Plugin;
+using Vamp::RealTime;
+using Vamp::HostExt::PluginLoader;
+using Vamp::HostExt::PluginWrapper;
+using Vamp::HostExt::PluginChannelAdapter;
+using Vamp::HostExt::SpectralSource;
+
+static int failures = 0;
+
+static void
+check(bool condition, string what)
+{
+    if (!condition) {
+        cerr << "FAIL: " << what << endl;
+        ++failures;
+    }
+}
+
+static const float rate = 44100.f;
+static const size_t blockSize = 1024;
+static const int blocks = 20;
+
+static Plugin *
+load(SpectralSource *source, const vector<float> &gains)
+{
+    PluginLoader *loader = PluginLoader::getInstance();
+    Plugin *plugin = loader->loadPlugin
+        ("vamp-example-plugins:powerspectrum", rate,
+         PluginLoader::ADAPT_ALL, source);
+    if (!plugin) return 0;
+
+    PluginChannelAdapter *ca = dynamic_cast<PluginWrapper *>(plugin)->
+        getWrapper<PluginChannelAdapter>();
+    if (!ca) {
+        delete plugin;
+        return 0;
+    }
+    ca->setMixGains(gains);
+
+    if (!plugin->initialise(2, blockSize, blockSize)) {
+        delete plugin;
+        return 0;
+    }
+    return plugin;
+}
+
+static bool
+sameFeatures(const Plugin::FeatureSet &a, const Plugin::FeatureSet &b)
+{
+    if (a.size() != b.size()) return false;
+    for (Plugin::FeatureSet::const_iterator i = a.begin(), j = b.begin();
+         i != a.end(); ++i, ++j) {
+        if (i->first != j->first) return false;
+        if (i->second.size() != j->second.size()) return false;
+        for (size_t k = 0; k < i->second.size(); ++k) {
+            if (i->second[k].values != j->second[k].values) return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        cerr << "Usage: " << argv[0] << " pluginlibrary" << endl;
+        return 2;
+    }
+
+    // Find the library given, as the only one on the path
+    string library = argv[1];
+    string dir = ".";
+    string::size_type slash = library.find_last_of("/\\");
+    if (slash != string::npos) dir = library.substr(0, slash);
+#ifdef _WIN32
+    _putenv_s("VAMP_PATH", dir.c_str());
+#else
+    setenv("VAMP_PATH", dir.c_str(), 1);
+#endif
+
+    vector<float> left(2), right(2), none;
+    left[0] = 1.f;
+    right[1] = 1.f;
+
+    const vector<float> *gains[] = { &left, &right, &left, &none };
+    const char *names[] = { "left", "right", "left again", "mean" };
+    const int n = 4;
+
+    SpectralSource source;
+    Plugin *shared[n], *alone[n];
+    for (int i = 0; i < n; ++i) {
+        shared[i] = load(&source, *gains[i]);
+        alone[i] = load(0, *gains[i]);
+        if (!shared[i] || !alone[i]) {
+            cerr << "Failed to load power spectrum plugin from "
+                 << library << endl;
+            return 1;
+        }
+    }
+
+    vector<float> l(blockSize), r(blockSize);
+    const float *input[2] = { &l[0], &r[0] };
+
+    for (int b = 0; b < blocks; ++b) {
+
+        for (size_t j = 0; j < blockSize; ++j) {
+            size_t frame = b * blockSize + j;
+            l[j] = sinf(float(frame) * 0.05f);
+            r[j] = 0.5f * sinf(float(frame) * 0.31f);
+        }
+
+        RealTime t = RealTime::frame2RealTime(long(b * blockSize), int(rate));
+
+        for (int i = 0; i < n; ++i) {
+            Plugin::FeatureSet fs = shared[i]->process(input, t);
+            Plugin::FeatureSet fa = alone[i]->process(input, t);
+            check(sameFeatures(fs, fa),
+                  string("block ") + to_string(b) + ", " + names[i] +
+                  " mixdown with shared source");
+        }
+    }
+
+    for (int i = 0; i < n; ++i) {
+        delete shared[i];
+        delete alone[i];
+    }
+
+    if (failures > 0) {
+        cerr << failures << " check(s) failed" << endl;
+        return 1;
+    }
+    return 0;
+}
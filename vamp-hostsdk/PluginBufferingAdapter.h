@@ -67,6 +67,9 @@ namespace HostExt {
  * different sample rate specification.  This is necessary in order to
  * obtain correct time stamping.
  * 
+ * The adapter also offers a push mode for hosts that capture audio
+ * on one thread and analyse it on another. See setPushMode().
+ *
  * In other respects, the PluginBufferingAdapter behaves identically
  * to the plugin that it wraps. The wrapped plugin will be deleted
  * when the wrapper is deleted. If you wish to prevent this, call
@@ -179,8 +182,83 @@ public:
     void reset();
 
     FeatureSet process(const float *const *inputBuffers, RealTime timestamp);
+
+    /**
+     * Process an arbitrary number of sample frames at once, such as a
+     * whole file or a multi-second chunk of one, and add the
+     * resulting features to the given feature set. This is
+     * equivalent to slicing the input into blocks of the size passed
+     * to initialise() and calling process() on each, merging the
+     * results, but avoids the overhead of doing so.
+     *
+     * inputBuffers contains one array of frames samples per channel,
+     * and timestamp is the time of the first of them. Calls to
+     * processChunk() and process() may be mixed, provided each
+     * continues the input from where the last left off.
+     */
+    void processChunk(const float *const *inputBuffers, size_t frames,
+                      RealTime timestamp, FeatureSet &features);
     
     FeatureSet getRemainingFeatures();
+
+    /**
+     * As process(), but into a FeatureBuffer, replacing its contents;
+     * see PluginWrapper::processPluginInto().
+     */
+    void processInto(const float *const *inputBuffers, RealTime timestamp,
+                     FeatureBuffer &features);
+
+    /**
+     * As getRemainingFeatures(), but into a FeatureBuffer; see
+     * PluginWrapper::getRemainingPluginFeaturesInto().
+     */
+    void getRemainingFeaturesInto(FeatureBuffer &features);
+
+    /**
+     * Switch the adapter into push mode. In this mode, a single
+     * producer thread supplies input by calling push(), and a single
+     * consumer thread runs the plugin by calling pump(). Neither ever
+     * waits for the other, so a slow plugin cannot hold up the
+     * producer. process() may not be used in push mode.
+     *
+     * capacity is the number of sample frames that may be queued
+     * awaiting pump(). It is increased to the plugin's block size if
+     * smaller. The first pushed frame is taken to be at startTime.
+     *
+     * This must be called after initialise() and before the first
+     * call to push(). The adapter remains in push mode until it is
+     * destroyed. reset() returns the timestamps to startTime. All
+     * calls other than push() and pump() must be made while neither
+     * thread is using the adapter.
+     *
+     * Returns false if the adapter has not been initialised.
+     */
+    bool setPushMode(size_t capacity, RealTime startTime = RealTime::zeroTime);
+
+    /**
+     * Queue up to the given number of sample frames from the given
+     * buffers, one per channel, for processing by pump(). Returns the
+     * number of frames actually queued. This is less than requested
+     * if the queue is too full, in which case the caller should retry
+     * the rest later. Call only from the producer thread, in push
+     * mode.
+     */
+    size_t push(const float *const *inputBuffers, size_t frames);
+
+    /**
+     * Run the plugin on every whole block queued by push(), and
+     * return the resulting features. Call only from the consumer
+     * thread, in push mode. When the producer has finished, call
+     * getRemainingFeatures() on the consumer thread to process any
+     * remaining partial block and collect the final features.
+     */
+    FeatureSet pump();
+
+    /**
+     * As pump(), but returning the features in the given buffer,
+     * replacing any it already contained (see processInto()).
+     */
+    void pumpInto(FeatureBuffer &features);
     
 protected:
     class Impl;
@@ -66,7 +66,8 @@ namespace HostExt {
  *  - If the plugin only supports exactly one channel but more than
  *  one channel is provided, PluginChannelAdapter will use the mean of
  *  the channels.  This ensures that the resulting values remain
- *  within the same magnitude range as expected for mono data.
+ *  within the same magnitude range as expected for mono data.  A
+ *  weighted sum may be used instead by calling setMixGains().
  *
  *  - If the plugin requires more than one channel but exactly one is
  *  provided, the provided channel will be duplicated across all the
@@ -125,20 +126,70 @@ public:
 
     FeatureSet process(const float *const *inputBuffers, RealTime timestamp);
 
+    /**
+     * As process(), but into a FeatureBuffer, replacing its contents;
+     * see PluginWrapper::processPluginInto().
+     */
+    void processInto(const float *const *inputBuffers, RealTime timestamp,
+                     FeatureBuffer &features);
+
+    /**
+     * As getRemainingFeatures(), but into a FeatureBuffer; see
+     * PluginWrapper::getRemainingPluginFeaturesInto().
+     */
+    void getRemainingFeaturesInto(FeatureBuffer &features);
+
     /**
      * Call process(), providing interleaved audio data with the
      * number of channels passed to initialise().  The adapter will
      * de-interleave into temporary buffers as appropriate before
-     * calling process().
+     * calling process().  If the wrapped plugin supports strided
+     * input (see PluginWrapper::pluginSupportsStridedInput) and no
+     * mixing or padding of channels is needed, the interleaved
+     * data is passed to it through processStrided() without being
+     * copied at all.
      *
      * \note This function was introduced in version 1.4 of the Vamp
      * plugin SDK.
      */
     FeatureSet processInterleaved(const float *inputBuffer, RealTime timestamp);
 
+    /**
+     * Return true: the adapter accepts strided input in every case,
+     * passing it on to the wrapped plugin unchanged where that
+     * supports strided input itself, and copying it into temporary
+     * buffers otherwise.
+     */
+    bool supportsStridedInput() const;
+
+    /**
+     * As process(), but with each channel of input supplied as a
+     * strided view (see PluginWrapper::processPluginStrided).
+     */
+    FeatureSet processStrided(const float *const *inputBuffers, size_t stride,
+                              RealTime timestamp);
+
+    /**
+     * Set the gains to apply to each input channel when mixing down
+     * for a plugin that accepts only one channel. The plugin then
+     * receives the sum of the input channels each multiplied by its
+     * gain, instead of their mean. For example, 5.1 input in the
+     * order L, R, C, LFE, Ls, Rs might be folded down with gains of
+     * 0.5, 0.5, 0.707, 0, 0.354, 0.354.
+     *
+     * There must be exactly one gain for each of the channels passed
+     * to initialise(); if not, the gains are ignored and the mean is
+     * used as usual. Pass an empty vector to return to the mean. The
+     * gains have no effect unless the adapter is mixing down to mono.
+     * They may be changed between calls to process().
+     */
+    void setMixGains(const std::vector<float> &gains);
+
 protected:
     class Impl;
     Impl *m_impl;
+
+    void notifyMixGains();
 };
 
 }
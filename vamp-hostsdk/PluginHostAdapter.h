@@ -48,6 +48,10 @@ _VAMP_SDK_HOSTSPACE_BEGIN(PluginHostAdapter.h)
 
 namespace Vamp {
 
+namespace HostExt {
+class FeatureBuffer;
+}
+
 /**
  * \class PluginHostAdapter PluginHostAdapter.h <vamp-hostsdk/PluginHostAdapter.h>
  * 
@@ -107,8 +111,28 @@ public:
 
     FeatureSet getRemainingFeatures();
 
+    /**
+     * As process(), but returning the features in the given buffer,
+     * replacing any it already contained. The plugin's features are
+     * copied into storage retained by the buffer from earlier calls,
+     * so once the buffer has grown to fit the plugin's output, this
+     * needs no memory allocation on the host side. See
+     * HostExt::PluginWrapper::processPluginInto(), which passes the
+     * buffer on to this function when given a PluginHostAdapter.
+     */
+    void processInto(const float *const *inputBuffers, RealTime timestamp,
+                     HostExt::FeatureBuffer &features);
+
+    /**
+     * As getRemainingFeatures(), but returning the features in the
+     * given buffer, as for processInto().
+     */
+    void getRemainingFeaturesInto(HostExt::FeatureBuffer &features);
+
 protected:
     void convertFeatures(VampFeatureList *, FeatureSet &);
+    void convertFeatures(VampFeatureList *, HostExt::FeatureBuffer &);
+    void convertFeature(const VampFeatureList &, unsigned int, Feature &) const;
 
     const VampPluginDescriptor *m_descriptor;
     VampPluginHandle m_handle;
@@ -46,6 +46,8 @@ namespace Vamp {
 
 namespace HostExt {
 
+class SpectralSource;
+
 /**
  * \class PluginInputDomainAdapter PluginInputDomainAdapter.h <vamp-hostsdk/PluginInputDomainAdapter.h>
  * 
@@ -70,7 +72,9 @@ namespace HostExt {
  *
  * The FFT implementation is simple and self-contained, but unlikely
  * to be the fastest available: a host can usually do better if it
- * cares enough.
+ * cares enough. Because the plugin receives its frequency-domain
+ * input as floats, the windowing and FFT are carried out in single
+ * precision throughout.
  *
  * The window shape for the FFT frame can be set using setWindowType
  * and the current shape retrieved using getWindowType.  (This was
@@ -106,6 +110,37 @@ public:
 
     FeatureSet process(const float *const *inputBuffers, RealTime timestamp);
 
+    /**
+     * Return true if processStrided() may be called with a stride
+     * greater than one. This is always the case for a plugin that
+     * expects frequency-domain input, as the adapter windows the
+     * input into its own buffers in any case. For a time-domain
+     * plugin the input is passed straight through, so this returns
+     * true only if the wrapped plugin supports strided input itself
+     * (see PluginWrapper::pluginSupportsStridedInput).
+     */
+    bool supportsStridedInput() const;
+
+    /**
+     * As process(), but with each channel of input supplied as a
+     * strided view (see PluginWrapper::processPluginStrided).
+     */
+    FeatureSet processStrided(const float *const *inputBuffers, size_t stride,
+                              RealTime timestamp);
+
+    /**
+     * As process(), but into a FeatureBuffer, replacing its contents;
+     * see PluginWrapper::processPluginInto().
+     */
+    void processInto(const float *const *inputBuffers, RealTime timestamp,
+                     FeatureBuffer &features);
+
+    /**
+     * As getRemainingFeatures(), but into a FeatureBuffer; see
+     * PluginWrapper::getRemainingPluginFeaturesInto().
+     */
+    void getRemainingFeaturesInto(FeatureBuffer &features);
+
     /**
      * ProcessTimestampMethod determines how the
      * PluginInputDomainAdapter handles timestamps for the data passed
@@ -222,10 +257,160 @@ public:
      */
     void setWindowType(WindowType type);
 
+    /**
+     * The forms in which the adapter can make the polar form of the
+     * spectra available alongside the complex spectra it passes to
+     * the plugin.
+     */
+    enum PolarOutput {
+
+        /**
+         * Calculate only the complex spectra. This is the default.
+         */
+        NoPolarOutput,
+
+        /**
+         * Also calculate the magnitude of each bin, for retrieval
+         * with getMagnitudes().
+         */
+        MagnitudeOutput,
+
+        /**
+         * Also calculate the magnitude and phase of each bin, for
+         * retrieval with getMagnitudes() and getPhases().
+         */
+        MagnitudeAndPhaseOutput
+    };
+
+    /**
+     * Return the current polar output setting. The default is
+     * NoPolarOutput.
+     */
+    PolarOutput getPolarOutput() const;
+
+    /**
+     * Set whether the adapter should calculate the polar form of
+     * each frame's spectra as well as the complex form. This is
+     * useful for a plugin that works from magnitudes (most do) and
+     * that the host runs in-process with access to this adapter: it
+     * can then pick up the magnitudes, calculated once using vector
+     * instructions where available, rather than derive them itself.
+     * When the adapter has a SpectralSource, the polar form is shared
+     * as well.
+     *
+     * This has no effect for plugins that take time-domain input.
+     */
+    void setPolarOutput(PolarOutput output);
+
+    /**
+     * Return the magnitudes of the frame most recently passed to the
+     * plugin, as one array of blockSize/2+1 values per channel, or 0
+     * if there is no such frame or magnitudes are not being
+     * calculated. They are available from the start of the plugin's
+     * process() call, and remain valid until the next call to
+     * process() or reset() on this adapter or on any other adapter
+     * sharing its SpectralSource.
+     */
+    const float *const *getMagnitudes() const;
+
+    /**
+     * Return the phases, in radians, of the frame most recently
+     * passed to the plugin, arranged and valid as for
+     * getMagnitudes(), or 0 if phases are not being calculated.
+     */
+    const float *const *getPhases() const;
+
+    /**
+     * Share this adapter's FFTs with any other adapters using the
+     * same SpectralSource. See SpectralSource for the conditions
+     * under which this is valid. Pass 0 to stop sharing.
+     *
+     * The source must outlive this adapter, or be detached from it
+     * first by calling setSpectralSource(0).
+     */
+    void setSpectralSource(SpectralSource *source);
+
+    /**
+     * Return the SpectralSource set with setSpectralSource, or 0 if
+     * there is none.
+     */
+    SpectralSource *getSpectralSource() const;
+
+protected:
+    class Impl;
+    Impl *m_impl;
+
+    friend class PluginChannelAdapter;
+
+    /**
+     * Record the gains with which a PluginChannelAdapter wrapping
+     * this adapter mixes its input down to mono, or an empty vector
+     * if it does not apply gains. Adapters only share spectra through
+     * a SpectralSource if their gains are equal, as otherwise their
+     * plugins receive different audio at the same timestamps.
+     */
+    void setUpstreamMixGains(const std::vector<float> &gains);
+};
+
+/**
+ * \class SpectralSource PluginInputDomainAdapter.h <vamp-hostsdk/PluginInputDomainAdapter.h>
+ *
+ * SpectralSource allows several PluginInputDomainAdapters that are
+ * running on the same audio stream to share the windowed FFTs they
+ * compute, so that a host running many frequency-domain plugins over
+ * one file pays for each frame's FFT only once.
+ *
+ * Attach adapters to a source with
+ * PluginInputDomainAdapter::setSpectralSource, or by loading plugins
+ * through the PluginLoader::loadPlugin overload that accepts one. An
+ * adapter that is asked for a frame looks first for a spectrum
+ * already calculated by another adapter with the same channel count,
+ * block size and window type, and the same ProcessTimestampMethod
+ * (ShiftTimestamp and NoShift are treated as the same, as they
+ * differ only in the timestamp given to the plugin) and, for
+ * ShiftData, the same step size. Failing that, it calculates the
+ * spectrum itself and leaves it in the source for the others.
+ *
+ * Frames are matched by the timestamp passed to process(). It is
+ * therefore only valid to share a source among adapters that each
+ * receive identical samples at identical timestamps, as seen by the
+ * input-domain adapter itself, i.e. after any channel adaptation
+ * outside it. Typically these are the plugins a host is running
+ * together over a single file, fed the same channels from the same
+ * starting point. Mix gains set with PluginChannelAdapter::setMixGains
+ * on a channel adapter wrapping the input-domain adapter (as
+ * PluginLoader arranges them) are taken into account: adapters whose
+ * gains differ do not share spectra. Any other difference in what
+ * the adapters are fed is not detected, and will give a plugin
+ * another plugin's spectra. Adapters clear their part of the source
+ * when reset, and reset() clears all of it; a host reusing its
+ * plugins for another stream must reset them (as it would have to
+ * anyway) before starting.
+ *
+ * Spectra are retained until every adapter sharing them has moved
+ * past them, up to a limit of a few tens of megabytes per group of
+ * matching adapters, after which the oldest are discarded and
+ * recalculated if needed.
+ *
+ * A SpectralSource is not thread-safe: all the adapters using it must
+ * be called from the same thread.
+ */
+class SpectralSource
+{
+public:
+    SpectralSource();
+    ~SpectralSource();
+
+    /**
+     * Discard all retained spectra.
+     */
+    void reset();
 
 protected:
     class Impl;
     Impl *m_impl;
+
+    friend class PluginInputDomainAdapter;
 };
 
 }
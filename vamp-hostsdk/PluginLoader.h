@@ -52,6 +52,8 @@ class Plugin;
 
 namespace HostExt {
 
+class SpectralSource;
+
 /**
  * \class PluginLoader PluginLoader.h <vamp-hostsdk/PluginLoader.h>
  * 
@@ -66,6 +68,12 @@ namespace HostExt {
  * class, and are certainly not required to use this actual class.
  * But we do strongly recommend it.
  *
+ * PluginLoader can optionally avoid loading every plugin library
+ * each time a process lists the available plugins, by recording what
+ * it found in each library in a cache file and loading only those
+ * libraries whose size or modification time has changed since. This
+ * is off by default; see setLibraryCacheEnabled().
+ *
  * This class is not thread-safe; use it from a single application
  * thread, or guard access to it with a mutex.
  *
@@ -228,6 +236,20 @@ public:
     Plugin *loadPlugin(PluginKey key,
                        float inputSampleRate,
                        int adapterFlags = 0);
+
+    /**
+     * Load a Vamp plugin as above, and if it is wrapped in a
+     * PluginInputDomainAdapter, have that adapter share its FFTs
+     * through the given SpectralSource. Use this when loading several
+     * frequency-domain plugins that will all be run over the same
+     * audio stream. The source must outlive the returned plugin.
+     *
+     * \see SpectralSource
+     */
+    Plugin *loadPlugin(PluginKey key,
+                       float inputSampleRate,
+                       int adapterFlags,
+                       SpectralSource *source);
     
     /**
      * Given a Vamp plugin library name and plugin identifier, return
@@ -260,6 +282,30 @@ public:
      */
     std::string getLibraryPathForPlugin(PluginKey plugin);
 
+    /**
+     * Enable or disable the on-disk cache of plugin library contents
+     * (disabled by default). When enabled, the loader records the
+     * plugin identifiers found in each library in a file in a "vamp"
+     * subdirectory of the user's cache directory (XDG_CACHE_HOME,
+     * ~/.cache, ~/Library/Caches or LOCALAPPDATA, depending on
+     * platform), and on later runs loads only those libraries whose
+     * size or modification time has changed since.
+     *
+     * The cache is only correct for libraries whose set of plugins
+     * is fixed when they are built. A library that decides what
+     * plugins to offer when it is loaded (for example one that wraps
+     * scripts found on a search path) will go on being listed with
+     * the plugins it had when it was cached, until the library file
+     * itself changes.
+     *
+     * The environment variable VAMP_PLUGIN_CACHE overrides this
+     * setting: set it to the path of a file to enable the cache
+     * using that file, or to the empty string to disable the cache.
+     *
+     * Call this before listing or loading any plugins.
+     */
+    void setLibraryCacheEnabled(bool enabled);
+
 protected:
     PluginLoader();
     virtual ~PluginLoader();
@@ -102,6 +102,19 @@ public:
     FeatureSet process(const float *const *inputBuffers, RealTime timestamp);
     FeatureSet getRemainingFeatures();
 
+    /**
+     * As process(), but into a FeatureBuffer, replacing its contents;
+     * see PluginWrapper::processPluginInto().
+     */
+    void processInto(const float *const *inputBuffers, RealTime timestamp,
+                     FeatureBuffer &features);
+
+    /**
+     * As getRemainingFeatures(), but into a FeatureBuffer; see
+     * PluginWrapper::getRemainingPluginFeaturesInto().
+     */
+    void getRemainingFeaturesInto(FeatureBuffer &features);
+
     typedef std::set<RealTime> SegmentBoundaries;
 
     /**
@@ -46,6 +46,184 @@ namespace Vamp {
 
 namespace HostExt {
 
+/**
+ * \class FeatureBuffer PluginWrapper.h <vamp-hostsdk/PluginWrapper.h>
+ *
+ * FeatureBuffer is a container for the features returned from a
+ * plugin, for use with PluginWrapper::processPluginInto() and
+ * PluginWrapper::getRemainingPluginFeaturesInto() as an alternative
+ * to the Plugin::FeatureSet returned by process().
+ *
+ * Unlike a FeatureSet, a FeatureBuffer keeps all of its storage when
+ * it is cleared, including the value vectors and labels of the
+ * features it has held, and reuses it for the next features added to
+ * the same output. A host that passes the same FeatureBuffer to every
+ * call will therefore find that, once the plugin's output has reached
+ * its typical size, no further memory allocation is needed to return
+ * it. Storage may also be reserved in advance using reserve().
+ *
+ * Features are indexed by output number and then by their order of
+ * addition within that output, as in a FeatureSet.
+ */
+class FeatureBuffer
+{
+public:
+    FeatureBuffer();
+    ~FeatureBuffer();
+
+    /**
+     * Remove all features, retaining their storage for reuse.
+     */
+    void clear();
+
+    /**
+     * Ensure that there is storage for at least the given number of
+     * features on the given output, each with room for at least the
+     * given number of values.
+     */
+    void reserve(int output, size_t features, size_t values);
+
+    /**
+     * Return true if there are no features on any output.
+     */
+    bool empty() const;
+
+    /**
+     * Return one more than the highest output number for which this
+     * buffer has storage. Outputs below this number may nonetheless
+     * have no features; check getFeatureCount().
+     */
+    int getOutputCount() const;
+
+    /**
+     * Return the number of features on the given output.
+     */
+    size_t getFeatureCount(int output) const;
+
+    /**
+     * Return the given feature on the given output, which must be
+     * less than getFeatureCount(output).
+     */
+    Plugin::Feature &getFeature(int output, size_t index) {
+        return m_lists[output][index];
+    }
+    const Plugin::Feature &getFeature(int output, size_t index) const {
+        return m_lists[output][index];
+    }
+
+    /**
+     * Add a feature to the end of the given output and return it for
+     * the caller to fill in. The feature has no timestamp, duration,
+     * values or label, but may retain storage from an earlier use.
+     *
+     * The output number must not be negative. If it is, an error is
+     * reported and the feature returned is a scratch feature that is
+     * not part of the buffer.
+     */
+    Plugin::Feature &addFeature(int output);
+
+    /**
+     * Add a copy of the given feature to the end of the given output,
+     * and return the copy. As above, a negative output number is
+     * reported as an error and the feature is not added.
+     */
+    Plugin::Feature &addFeature(int output, const Plugin::Feature &feature);
+
+    /**
+     * Add copies of all of the features in the given feature set, at
+     * the ends of their respective outputs. Features on negative
+     * output numbers are ignored.
+     */
+    void addFeatures(const Plugin::FeatureSet &features);
+
+    /**
+     * Add copies of all of the features in the given buffer, at the
+     * ends of their respective outputs.
+     */
+    void addFeatures(const FeatureBuffer &features);
+
+    /**
+     * Add copies of all of the features in this buffer to the given
+     * feature set, at the ends of their respective outputs.
+     */
+    void addTo(Plugin::FeatureSet &features) const;
+
+    /**
+     * Return the features as a FeatureSet, as process() would have.
+     * Outputs with no features are omitted.
+     */
+    Plugin::FeatureSet toFeatureSet() const;
+
+protected:
+    std::vector<Plugin::FeatureList> m_lists;
+    std::vector<size_t> m_counts;
+    Plugin::Feature m_scratch; // returned for an invalid output number
+};
+
+/**
+ * \class FeatureBufferProcessor PluginWrapper.h <vamp-hostsdk/PluginWrapper.h>
+ *
+ * FeatureBufferProcessor is an interface that a plugin wrapper may
+ * implement, in addition to deriving from PluginWrapper, to return
+ * its features into a FeatureBuffer without building a FeatureSet.
+ * Hosts and other wrappers do not call it directly, but through
+ * PluginWrapper::processPluginInto() and
+ * PluginWrapper::getRemainingPluginFeaturesInto(), which also know
+ * about the adapters in this SDK and about PluginHostAdapter.
+ */
+class FeatureBufferProcessor
+{
+public:
+    virtual ~FeatureBufferProcessor() { }
+
+    /**
+     * As Plugin::process(), but returning the features in the given
+     * buffer, replacing any it already contained.
+     */
+    virtual void processInto(const float *const *inputBuffers,
+                             RealTime timestamp,
+                             FeatureBuffer &features) = 0;
+
+    /**
+     * As Plugin::getRemainingFeatures(), but returning the features
+     * in the given buffer, replacing any it already contained.
+     */
+    virtual void getRemainingFeaturesInto(FeatureBuffer &features) = 0;
+};
+
+/**
+ * \class StridedInputProcessor PluginWrapper.h <vamp-hostsdk/PluginWrapper.h>
+ *
+ * StridedInputProcessor is an interface that a plugin wrapper may
+ * implement, in addition to deriving from PluginWrapper, to show that
+ * it can read its input in place without needing it to be contiguous.
+ * Hosts and other wrappers do not call it directly, but through
+ * PluginWrapper::pluginSupportsStridedInput() and
+ * PluginWrapper::processPluginStrided(), which also know about the
+ * adapters in this SDK that accept strided input.
+ */
+class StridedInputProcessor
+{
+public:
+    virtual ~StridedInputProcessor() { }
+
+    /**
+     * Return true if processStrided() may be called with a stride
+     * greater than one. The result may depend on the wrapped plugin,
+     * but will not change once the plugin has been initialised.
+     */
+    virtual bool supportsStridedInput() const = 0;
+
+    /**
+     * As Plugin::process(), but with each channel of input supplied
+     * as a strided view: sample i of channel c is found at
+     * inputBuffers[c][i * stride].
+     */
+    virtual Plugin::FeatureSet processStrided(const float *const *inputBuffers,
+                                              size_t stride,
+                                              RealTime timestamp) = 0;
+};
+
 /**
  * \class PluginWrapper PluginWrapper.h <vamp-hostsdk/PluginWrapper.h>
  * 
@@ -139,8 +317,78 @@ public:
      */
     void disownPlugin();
     
+    /**
+     * Return true if processPluginStrided() may be called for the
+     * given plugin with a stride greater than one. This is the case
+     * for a PluginInputDomainAdapter or PluginChannelAdapter that
+     * reports supportsStridedInput(), and for any other plugin that
+     * implements StridedInputProcessor and reports that it supports
+     * strided input. A subclass of one of the adapters in this SDK is
+     * not assumed to accept strided input unless it implements
+     * StridedInputProcessor itself.
+     */
+    static bool pluginSupportsStridedInput(const Plugin *plugin);
+
+    /**
+     * Call process() on the given plugin, but with each channel of
+     * input supplied as a strided view: sample i of channel c is
+     * found at inputBuffers[c][i * stride]. For example, interleaved
+     * input with n channels may be passed with inputBuffers[c]
+     * pointing to the c'th sample of the interleaved buffer and a
+     * stride of n.
+     *
+     * A stride of one is equivalent to calling process(). Any other
+     * stride may only be used if pluginSupportsStridedInput() returns
+     * true for the plugin; otherwise an error is reported and no
+     * features are returned.
+     */
+    static FeatureSet processPluginStrided(Plugin *plugin,
+                                           const float *const *inputBuffers,
+                                           size_t stride,
+                                           RealTime timestamp);
+
+    /**
+     * Call process() on the given plugin, returning the features in
+     * the given buffer, replacing any it already contained, rather
+     * than in a new FeatureSet. Pass the same buffer to each call to
+     * avoid memory allocation once it has grown to a sufficient size
+     * (see FeatureBuffer).
+     *
+     * Allocation can only be avoided entirely if the plugin can
+     * return features without building a FeatureSet. The adapters
+     * in this SDK pass the buffer on through one another to the
+     * plugin they adapt, and a PluginHostAdapter (as used for plugins
+     * loaded from a library) fills it directly from the plugin's own
+     * feature list. Any other plugin may do the same by implementing
+     * FeatureBufferProcessor. Otherwise process() is called and its
+     * result copied into the buffer.
+     *
+     * The adapters and PluginHostAdapter provide this through their
+     * own processInto() and getRemainingFeaturesInto() functions.
+     * These are plain member functions, not overrides of anything in
+     * Plugin, so code holding only a Plugin pointer cannot reach them
+     * directly; it should call this function, which recognises them
+     * by the plugin's exact type. As with strided input, a subclass
+     * of one of these classes is therefore treated as any other
+     * plugin and has process() called, since it may have overridden
+     * process() but not processInto().
+     */
+    static void processPluginInto(Plugin *plugin,
+                                  const float *const *inputBuffers,
+                                  RealTime timestamp,
+                                  FeatureBuffer &features);
+
+    /**
+     * Call getRemainingFeatures() on the given plugin, returning the
+     * features in the given buffer, replacing any it already
+     * contained, as for processPluginInto().
+     */
+    static void getRemainingPluginFeaturesInto(Plugin *plugin,
+                                               FeatureBuffer &features);
+
 protected:
     PluginWrapper(Plugin *plugin); // I take ownership of plugin
+
     Plugin *m_plugin;
     bool m_pluginIsOwned;
 };
@@ -44,10 +44,13 @@ namespace Vamp {
 
 /**
  * A simple FFT implementation provided for convenience of plugin
- * authors. This class provides one-shot (i.e. fixed table state is
- * recalculated every time) double-precision complex-complex
- * transforms. For repeated transforms from real time-domain data, use
- * an FFTComplex or FFTReal object instead.
+ * authors. This class provides one-shot double-precision
+ * complex-complex transforms. The fixed table state for each size and
+ * direction is kept in a small process-wide cache, so repeated calls
+ * with the same size do not recalculate it, and the functions may be
+ * called from more than one thread at once. For repeated transforms
+ * from real time-domain data, an FFTComplex or FFTReal object is
+ * still likely to be more efficient.
  *
  * Note: If the SDK has been compiled with the SINGLE_PRECISION_FFT
  * flag, then all FFTs will use single precision internally. The
@@ -102,6 +105,8 @@ public:
  * Note: If the SDK has been compiled with the SINGLE_PRECISION_FFT
  * flag, then all FFTs will use single precision internally. The
  * default is double precision. The API uses doubles in either case.
+ * See FFTComplexFloat for a class that uses single precision
+ * throughout.
  *
  * The forward transform is unscaled; the inverse transform is scaled
  * by 1/n.
@@ -154,6 +159,7 @@ private:
  * Note: If the SDK has been compiled with the SINGLE_PRECISION_FFT
  * flag, then all FFTs will use single precision internally. The
  * default is double precision. The API uses doubles in either case.
+ * See FFTRealFloat for a class that uses single precision throughout.
  *
  * The forward transform is unscaled; the inverse transform is scaled
  * by 1/n.
@@ -191,6 +197,164 @@ public:
      */
     void inverse(const double *ci, double *ro);
 
+    /**
+     * Calculate forward transforms of size n for count frames in a
+     * single call. This gives the same results as calling forward()
+     * once per frame, but avoids the per-call overhead and keeps the
+     * transform's tables in cache from one frame to the next.
+     *
+     * ri must point to the first of count real input frames of size
+     * n, each starting inStride doubles after the one before. The
+     * stride may be less than n, in which case successive frames
+     * overlap: for example, an inStride equal to the hop size
+     * transforms successive frames of a single contiguous signal.
+     *
+     * co must point to enough space to receive count interleaved
+     * complex output frames of size n/2+1 (n+2 doubles each), each
+     * starting outStride doubles after the one before. outStride must
+     * be at least n+2.
+     *
+     * The input and output arrays must not overlap.
+     */
+    void forwardBatch(const double *ri, unsigned int inStride,
+                      double *co, unsigned int outStride,
+                      unsigned int count);
+
+    /**
+     * Calculate inverse transforms of size n for count frames in a
+     * single call, giving the same results as calling inverse() once
+     * per frame.
+     *
+     * ci must point to the first of count interleaved complex input
+     * frames of size n/2+1 (n+2 doubles each), each starting inStride
+     * doubles after the one before.
+     *
+     * ro must point to enough space to receive count real output
+     * frames of size n, each starting outStride doubles after the one
+     * before. outStride must be at least n. Each output is scaled by
+     * 1/n.
+     *
+     * The input and output arrays must not overlap.
+     */
+    void inverseBatch(const double *ci, unsigned int inStride,
+                      double *ro, unsigned int outStride,
+                      unsigned int count);
+
+private:
+    class D;
+    D *m_d;
+};
+
+/**
+ * A single-precision counterpart to FFTComplex. This class provides
+ * float complex-complex transforms, computed in single precision
+ * throughout, for plugins that have no use for double-precision
+ * results. It uses half the memory bandwidth of FFTComplex and avoids
+ * converting to and from double.
+ *
+ * The forward transform is unscaled; the inverse transform is scaled
+ * by 1/n.
+ */
+class FFTComplexFloat
+{
+public:
+    /**
+     * Prepare to calculate transforms of size n.
+     * n must be a multiple of 2.
+     */
+    FFTComplexFloat(unsigned int n);
+
+    ~FFTComplexFloat();
+
+    /**
+     * Calculate a forward transform of size n.
+     *
+     * ci must point to the interleaved complex input data of size n
+     * (that is, 2n floats in total).
+     *
+     * co must point to enough space to receive an interleaved complex
+     * output array of size n (that is, 2n floats in total).
+     */
+    void forward(const float *ci, float *co);
+
+    /**
+     * Calculate an inverse transform of size n.
+     *
+     * ci must point to an interleaved complex input array of size n
+     * (that is, 2n floats in total).
+     *
+     * co must point to enough space to receive the interleaved
+     * complex output data of size n (that is, 2n floats in
+     * total). The output is scaled by 1/n.
+     */
+    void inverse(const float *ci, float *co);
+
+private:
+    class D;
+    D *m_d;
+};
+
+/**
+ * A single-precision counterpart to FFTReal. This class provides
+ * transforms between float real time-domain and float complex
+ * frequency-domain data, computed in single precision throughout. It
+ * uses half the memory bandwidth of FFTReal and avoids converting to
+ * and from double.
+ *
+ * The forward transform is unscaled; the inverse transform is scaled
+ * by 1/n.
+ */
+class FFTRealFloat
+{
+public:
+    /**
+     * Prepare to calculate transforms of size n.
+     * n must be a multiple of 2.
+     */
+    FFTRealFloat(unsigned int n);
+
+    ~FFTRealFloat();
+
+    /**
+     * Calculate a forward transform of size n.
+     *
+     * ri must point to the real input data of size n.
+     *
+     * co must point to enough space to receive an interleaved complex
+     * output array of size n/2+1 (that is, n+2 floats in total).
+     */
+    void forward(const float *ri, float *co);
+
+    /**
+     * Calculate an inverse transform of size n.
+     *
+     * ci must point to an interleaved complex input array of size
+     * n/2+1 (that is, n+2 floats in total).
+     *
+     * ro must point to enough space to receive the real output data
+     * of size n. The output is scaled by 1/n and only the real part
+     * is returned.
+     */
+    void inverse(const float *ci, float *ro);
+
+    /**
+     * Calculate forward transforms of size n for count frames in a
+     * single call. See FFTReal::forwardBatch for the layout of the
+     * input and output; strides here are counted in floats.
+     */
+    void forwardBatch(const float *ri, unsigned int inStride,
+                      float *co, unsigned int outStride,
+                      unsigned int count);
+
+    /**
+     * Calculate inverse transforms of size n for count frames in a
+     * single call. See FFTReal::inverseBatch for the layout of the
+     * input and output; strides here are counted in floats.
+     */
+    void inverseBatch(const float *ci, unsigned int inStride,
+                      float *ro, unsigned int outStride,
+                      unsigned int count);
+
 private:
     class D;
     D *m_d;